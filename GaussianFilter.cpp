@@ -1,13 +1,35 @@
 #include "GaussianFilter.h"
+#include "GaussianFilter_simd.h"
+#include "boxBlur.h"
+#include "bufferPool.h"
+#include "colorConvert.h"
+#include "colorConvert_simd.h"
+#include "cpuFeatures.h"
 #include "imgOps.h"
+#include "parallel.h"
 #include "scale.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
 
 //using namespace imgproc;
 imgproc::Kernel 
-imgproc::computeKernel(const uint8_t kernelSize, const float stdDev)
+imgproc::computeKernel(uint8_t kernelSize, const float stdDev)
 {
+    // no spread: every tap but the centre would be exp(-inf) and the
+    // centre 0/0
+    if (!(stdDev > 0))
+        return Kernel{ 1.f };
+
+    if (kernelSize == 0)
+        kernelSize = gaussianKernelSize(stdDev);
+
     Kernel kernel;
     kernel.resize(kernelSize);
 
@@ -33,31 +55,560 @@ imgproc::computeKernel(const uint8_t kernelSize, const float stdDev)
     return kernel;
 }
 
+uint8_t imgproc::gaussianKernelSize(const float stdDev)
+{
+    // also catches NaN, which std::max/min pass through to the cast (UB)
+    if (!(stdDev > 0))
+        return 1;
+    const float taps = std::ceil(6 * stdDev);
+    return static_cast<uint8_t>(static_cast<int>(std::min(taps, 255.f)) | 1);
+}
+
+namespace
+{
+    // a few dozen (size, sigma) pairs cover any real program; one that
+    // makes up new sigmas forever just starts the cache over now and then
+    constexpr size_t kernelCacheSize = 64;
+
+    std::mutex kernelCacheMutex;
+    std::map<std::pair<int, uint32_t>, std::shared_ptr<const imgproc::PreparedKernel>> kernelCache;
+}
+
+std::shared_ptr<const imgproc::PreparedKernel>
+imgproc::gaussianKernel(uint8_t kernelSize, const float stdDev)
+{
+    if (kernelSize == 0)
+        kernelSize = gaussianKernelSize(stdDev);
+
+    // keyed on sigma's bits so every float, NaN included, is its own key
+    uint32_t sigmaBits;
+    std::memcpy(&sigmaBits, &stdDev, sizeof(sigmaBits));
+    const std::pair<int, uint32_t> key(kernelSize, sigmaBits);
+
+    {
+        std::lock_guard<std::mutex> lock(kernelCacheMutex);
+        const auto found = kernelCache.find(key);
+        if (found != kernelCache.end())
+            return found->second;
+    }
+
+    // built outside the lock; if another thread got there first, its
+    // kernel is the one kept
+    auto kernel = std::make_shared<const PreparedKernel>(
+        prepareKernel(computeKernel(kernelSize, stdDev)));
+
+    std::lock_guard<std::mutex> lock(kernelCacheMutex);
+    if (kernelCache.size() >= kernelCacheSize)
+        kernelCache.clear();
+    return kernelCache.emplace(key, std::move(kernel)).first->second;
+}
+
 imgproc::Image 
 imgproc::padImage(const Image &img, const int padBy)
 {
     Image padded(img.rows + padBy * 2,
                  img.cols + padBy * 2,
-                 img.channels);
+                 img.channels, ImageInit::Uninitialized);
+
+    // padding stays black
+    embed(img.view(), padded.view(), padBy, padBy);
+
+    return padded;
+}
+
+void imgproc::padImage(ConstImageView src, ImageView dst, const int padBy)
+{
+    embed(src, dst, padBy, padBy);
+}
+
+
+namespace
+{
+    using namespace imgproc;
+
+    // the two row kernels for one element type. Buf is what the filtered
+    // rows are kept as between the passes, W the weight type.
+    template <typename T, typename Buf = float, typename W = float>
+    struct RowKernels
+    {
+        void (*horizontal)(const T* src, Buf* dst, int n, int channels,
+            const W* kernel, int taps);
+        void (*vertical)(const Buf* const* rows, const W* kernel,
+            int taps, T* dst, int n);
+    };
+
+    // per-band rings and rows come from the buffer pool, so blurring
+    // frames of one size stops allocating once the pool is warm
+    template <typename T>
+    using Scratch = std::vector<T, PoolAllocator<T>>;
+
+    template <typename T, int C>
+    void horizontalRowScalar(const T* src, float* dst, int n,
+        int channels, const float* kernel, int taps)
+    {
+        if constexpr (C != 0)
+            channels = C;
+
+        for (int i = 0; i < n; i++)
+        {
+            float acc{};
+            for (int k = 0; k < taps; k++)
+                acc += kernel[k] * src[i + k * channels];
+            dst[i] = acc;
+        }
+    }
+
+    // taps are `channels` apart; fixed at compile time for 1, 3 and 4
+    template <typename T>
+    void horizontalRowScalar(const T* src, float* dst, int n,
+        int channels, const float* kernel, int taps)
+    {
+        withChannels(channels, [&](auto c)
+        {
+            horizontalRowScalar<T, c>(src, dst, n, channels, kernel, taps);
+        });
+    }
+
+    template <typename T>
+    void verticalRowScalar(const float* const* rows, const float* kernel,
+        int taps, T* dst, int n)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            float acc{};
+            for (int k = 0; k < taps; k++)
+                acc += kernel[k] * rows[k][i];
+            dst[i] = saturateCast<T>(acc);
+        }
+    }
+
+    // uint8 gets the SIMD kernels; the wider types the scalar templates,
+    // which keep full precision between the two passes
+    template <typename T>
+    RowKernels<T> rowKernels()
+    {
+        return { horizontalRowScalar<T>, verticalRowScalar<T> };
+    }
+
+    template <>
+    RowKernels<uint8_t> rowKernels<uint8_t>()
+    {
+        const detail::SeparableRowKernels kernels = detail::selectRowKernels();
+        return { kernels.horizontal, kernels.vertical };
+    }
+
+    // fixed-point uint8 kernels, see GaussianFilter_simd.h
+    template <int C>
+    void horizontalRowFixedScalar(const uint8_t* src, uint16_t* dst, int n,
+        int channels, const uint16_t* kernel, int taps)
+    {
+        if constexpr (C != 0)
+            channels = C;
+
+        for (int i = 0; i < n; i++)
+        {
+            uint32_t acc = 0;
+            for (int k = 0; k < taps; k++)
+                acc += kernel[k] * src[i + k * channels];
+            dst[i] = static_cast<uint16_t>(acc);
+        }
+    }
+
+    void horizontalRowFixedScalar(const uint8_t* src, uint16_t* dst, int n,
+        int channels, const uint16_t* kernel, int taps)
+    {
+        withChannels(channels, [&](auto c)
+        {
+            horizontalRowFixedScalar<c>(src, dst, n, channels, kernel, taps);
+        });
+    }
+
+    void verticalRowFixedScalar(const uint16_t* const* rows, const uint16_t* kernel,
+        int taps, uint8_t* dst, int n)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            uint32_t acc = 1u << 23;
+            for (int k = 0; k < taps; k++)
+                acc += static_cast<uint32_t>(kernel[k]) * rows[k][i];
+            dst[i] = static_cast<uint8_t>(acc >> 24);
+        }
+    }
+
+    // weights scaled to sum to exactly `one`; what rounding lost or gained
+    // goes to the largest tap, so a symmetric kernel stays symmetric
+    // false if a tap does not fit uint16
+    bool quantizeKernel(const Kernel& kernel, float sum, int one,
+        std::vector<uint16_t>& out)
+    {
+        std::vector<long> q(kernel.size());
+        long total = 0;
+        for (size_t k = 0; k < kernel.size(); k++)
+        {
+            q[k] = std::lround(kernel[k] / sum * one);
+            total += q[k];
+        }
+        *std::max_element(q.begin(), q.end()) += one - total;
+
+        out.resize(q.size());
+        for (size_t k = 0; k < q.size(); k++)
+        {
+            if (q[k] < 0 || q[k] > 0xFFFF)
+                return false;
+            out[k] = static_cast<uint16_t>(q[k]);
+        }
+        return true;
+    }
+
+    // only smoothing kernels take the fixed-point path: no negative taps
+    // (the 16-bit horizontal sum must not overflow) and unit gain. a tap of
+    // nearly one (a delta) does not fit a Q16 uint16, so that stays float too
+    bool fixedPointKernel(const Kernel& kernel, PreparedKernel& fixed)
+    {
+        float sum = 0;
+        for (const float w : kernel)
+        {
+            if (!(w >= 0.f))
+                return false;
+            sum += w;
+        }
+        if (kernel.empty() || std::abs(sum - 1.f) > 1e-3f)
+            return false;
+
+        return quantizeKernel(kernel, sum, 1 << 8, fixed.fixedHorizontal)
+            && quantizeKernel(kernel, sum, 1 << 16, fixed.fixedVertical);
+    }
+
+    // horizontal pass over one source row into a filtered row.
+    // taps that fall outside the row read black, like a zero-padded image.
+    template <typename T, typename Buf, typename W>
+    void convolveRow(const RowKernels<T, Buf, W>& kernels, const T* src,
+        Buf* dst, int cols, int channels, const W* kernel, int taps)
+    {
+        const int left = taps / 2;
+        const int right = taps - 1 - left;
+
+        auto clipped = [&](int x)
+        {
+            const int kBegin = std::max(0, left - x);
+            const int kEnd = std::min(taps, cols - x + left);
+            for (int c = 0; c < channels; c++)
+            {
+                Buf acc{};
+                for (int k = kBegin; k < kEnd; k++)
+                    acc += kernel[k] * src[(x + k - left) * channels + c];
+                dst[x * channels + c] = acc;
+            }
+        };
+
+        const int interiorBegin = std::min(left, cols);
+        const int interiorEnd = std::max(interiorBegin, cols - right);
+
+        for (int x = 0; x < interiorBegin; x++)
+            clipped(x);
+
+        // interior: every tap is in range
+        kernels.horizontal(src + (interiorBegin - left) * channels,
+            dst + interiorBegin * channels, (interiorEnd - interiorBegin) * channels,
+            channels, kernel, taps);
+
+        for (int x = interiorEnd; x < cols; x++)
+            clipped(x);
+    }
+
+    // keep every other pixel of a horizontally filtered row
+    template <int C, typename Buf>
+    void decimateRow(const Buf* src, Buf* dst, int dstCols)
+    {
+        for (int x = 0; x < dstCols; x++)
+            for (int c = 0; c < C; c++)
+                dst[x * C + c] = src[x * 2 * C + c];
+    }
 
-    int startFromCol = padBy;
-    int startFromRow = padBy; 
-    for (int y = 0; y < padded.rows; y++)
+    template <typename Buf>
+    void decimateRow(const Buf* src, Buf* dst, int dstCols, int channels)
     {
-        for (int x = 0; x < padded.cols; x++)
+        switch (channels)
+        {
+        case 1: decimateRow<1>(src, dst, dstCols); break;
+        case 3: decimateRow<3>(src, dst, dstCols); break;
+        case 4: decimateRow<4>(src, dst, dstCols); break;
+        default:
+            for (int x = 0; x < dstCols; x++)
+                for (int c = 0; c < channels; c++)
+                    dst[x * channels + c] = src[x * 2 * channels + c];
+        }
+    }
+}
+
+imgproc::detail::SeparableRowKernels imgproc::detail::selectRowKernels()
+{
+    [[maybe_unused]] const SimdLevel level = simdLevel();
+#ifdef IMGPROC_HAVE_AVX2
+    if (level >= SimdLevel::AVX2)
+        return { horizontalRowAVX2, verticalRowAVX2 };
+#endif
+#ifdef IMGPROC_HAVE_SSE41
+    if (level >= SimdLevel::SSE41)
+        return { horizontalRowSSE41, verticalRowSSE41 };
+#endif
+    return { horizontalRowScalar<uint8_t>, verticalRowScalar<uint8_t> };
+}
+
+imgproc::detail::FixedRowKernels imgproc::detail::selectFixedRowKernels()
+{
+    [[maybe_unused]] const SimdLevel level = simdLevel();
+#ifdef IMGPROC_HAVE_AVX2
+    if (level >= SimdLevel::AVX2)
+        return { horizontalRowFixedAVX2, verticalRowFixedAVX2 };
+#endif
+#ifdef IMGPROC_HAVE_SSE41
+    if (level >= SimdLevel::SSE41)
+        return { horizontalRowFixedSSE41, verticalRowFixedSSE41 };
+#endif
+    return { horizontalRowFixedScalar, verticalRowFixedScalar };
+}
+
+namespace
+{
+    template <typename T, typename Buf, typename W>
+    void convolveSeparableT(ImageViewT<const T> src, ImageViewT<T> dst,
+        const RowKernels<T, Buf, W>& kernels, const W* hKernel, const W* vKernel, int taps)
+    {
+        /*
+            rather than padding the whole frame, keep a ring of the last
+            `taps` horizontally filtered rows (as floats, or uint16 in Q8 on
+            the fixed-point path, so the vertical pass sees unrounded
+            values).  output row y needs filtered rows
+            y - left .. y + right; rows outside the image read black.
+
+            src rows   ring        dst
+            y-1  -->   [h(y-1)]
+            y    -->   [h(y)  ] -->  y
+            y+1  -->   [h(y+1)]
+
+            bands of output rows run in parallel, each with its own ring; a band
+            re-filters the taps - 1 halo rows it shares with its neighbours.
+
+            in place (dst == src) a band's output would overwrite the halo rows
+            its neighbours still have to read, so bands are fixed up front and
+            the rows around every band boundary are filtered into a side buffer
+            before any band starts writing.
+        */
+
+        if (src.empty() || taps == 0)
+            return;
+
+        const int left = taps / 2;
+        const int right = taps - 1 - left;
+        const int rowElems = dst.rowElems();
+        const int grain = std::max(16, 4 * taps);
+
+        // colour in, gray out (8-bit only): each row is converted right before its
+        // horizontal pass, so neither a gray frame nor a colour blurred frame is ever made
+        const bool toGray = std::is_same_v<T, uint8_t> && src.channels == 3 && dst.channels == 1;
+        auto filterRow = [&](int r, Buf* out, [[maybe_unused]] T* grayRow)
+        {
+            const T* row = src.row(r);
+            if constexpr (std::is_same_v<T, uint8_t>)
+                if (toGray)
+                {
+                    detail::bgrToGrayRow(row, grayRow, src.cols);
+                    row = grayRow;
+                }
+            convolveRow(kernels, row, out, dst.cols, dst.channels, hKernel, taps);
+        };
+
+        const bool inPlace = src.data == dst.data && !toGray;
+        const int bandRows = std::max(grain, src.rows / (getNumThreads() * 4));
+        const int haloRows = taps - 1;
+        Scratch<Buf> halo; // haloRows filtered rows per interior band boundary
+
+        // filtered rows [boundary - left, boundary + right) of the band boundary at `boundary`
+        auto haloRow = [&](int boundary, int r)
+        {
+            const size_t slot = static_cast<size_t>(boundary / bandRows - 1) * haloRows + (r - boundary + left);
+            return halo.data() + slot * rowElems;
+        };
+
+        auto filterBand = [&](int yBegin, int yEnd)
+        {
+            Scratch<Buf> ring(static_cast<size_t>(taps) * rowElems);
+            Scratch<T> grayRow(toGray ? src.cols : 0);
+            Scratch<const Buf*> window(taps);
+            auto ringRow = [&](int y) { return ring.data() + static_cast<size_t>(y % taps) * rowElems; };
+
+            int filteredUpTo = std::max(0, yBegin - left); // next source row to run the horizontal pass on
+            for (int y = yBegin; y < yEnd; y++)
+            {
+                const int lastNeeded = std::min(y + right, src.rows - 1);
+                for (; filteredUpTo <= lastNeeded; filteredUpTo++)
+                {
+                    if (inPlace && (filteredUpTo < yBegin || filteredUpTo >= yEnd))
+                    {
+                        const Buf* saved = haloRow(filteredUpTo < yBegin ? yBegin : yEnd, filteredUpTo);
+                        std::copy(saved, saved + rowElems, ringRow(filteredUpTo));
+                        continue;
+                    }
+                    filterRow(filteredUpTo, ringRow(filteredUpTo), grayRow.data());
+                }
+
+                // vertical pass over the filtered rows that exist for this output row
+                const int kBegin = std::max(0, left - y);
+                const int kEnd = std::min(taps, src.rows - y + left);
+                for (int k = kBegin; k < kEnd; k++)
+                    window[k - kBegin] = ringRow(y + k - left);
+
+                kernels.vertical(window.data(), vKernel + kBegin, kEnd - kBegin,
+                    dst.row(y), rowElems);
+            }
+        };
+
+        if (!inPlace)
+        {
+            parallelFor(0, src.rows, filterBand, grain);
+            return;
+        }
+
+        const int bands = (src.rows + bandRows - 1) / bandRows;
+        if (haloRows > 0 && bands > 1)
         {
-            if (x >= startFromCol && x < (startFromCol + img.cols) &&
-                y >= startFromRow && y < (startFromRow + img.rows))
+            halo.resize(static_cast<size_t>(bands - 1) * haloRows * rowElems);
+            parallelFor(1, bands, [&](int bBegin, int bEnd)
+            {
+                for (int b = bBegin; b < bEnd; b++)
                 {
-                    padded.setPixel(y, x, 
-                        img.getPixel(y - startFromRow, x - startFromCol));
+                    const int boundary = b * bandRows;
+                    for (int r = std::max(0, boundary - left); r < std::min(src.rows, boundary + right); r++)
+                        filterRow(r, haloRow(boundary, r), nullptr);
                 }
+            });
         }
+
+        parallelFor(0, bands, [&](int bBegin, int bEnd)
+        {
+            for (int b = bBegin; b < bEnd; b++)
+                filterBand(b * bandRows, std::min(src.rows, (b + 1) * bandRows));
+        });
     }
-    return padded;
+
+    // uint8 with a smoothing kernel runs in fixed point: Q8 weights let the
+    // horizontal pass use 16-bit lanes, twice as many per register as float,
+    // and integer sums give the same output on every platform and SIMD level
+    template <typename T>
+    void convolveSeparableT(ImageViewT<const T> src, ImageViewT<T> dst,
+        const PreparedKernel& kernel)
+    {
+        const int taps = static_cast<int>(kernel.weights.size());
+        if constexpr (std::is_same_v<T, uint8_t>)
+        {
+            if (!kernel.fixedHorizontal.empty())
+            {
+                const detail::FixedRowKernels k = detail::selectFixedRowKernels();
+                const RowKernels<uint8_t, uint16_t, uint16_t> kernels{ k.horizontal, k.vertical };
+                convolveSeparableT(src, dst, kernels, kernel.fixedHorizontal.data(),
+                    kernel.fixedVertical.data(), taps);
+                return;
+            }
+        }
+
+        convolveSeparableT(src, dst, rowKernels<T>(), kernel.weights.data(), kernel.weights.data(), taps);
+    }
+
+    template <typename T>
+    void convolveSeparableT(ImageViewT<const T> src, ImageViewT<T> dst,
+        const Kernel& kernel)
+    {
+        // only uint8 needs the fixed-point taps
+        if constexpr (std::is_same_v<T, uint8_t>)
+            convolveSeparableT<T>(src, dst, prepareKernel(kernel));
+        else
+            convolveSeparableT(src, dst, rowKernels<T>(), kernel.data(), kernel.data(),
+                static_cast<int>(kernel.size()));
+    }
+
+    template <typename T>
+    ImageT<T> blurred(const ImageT<T>& img, const uint8_t kernelSize, const float stdDev)
+    {
+        if (img.empty())
+            return ImageT<T>{};
+
+        ImageT<T> gaussImg(img.rows, img.cols, img.channels, ImageInit::Uninitialized);
+        convolveSeparableT<T>(img.view(), gaussImg.view(), *gaussianKernel(kernelSize, stdDev));
+
+        return gaussImg;
+    }
+
+    template <typename T>
+    ImageT<T> blurredInPlace(ImageT<T>&& img, const uint8_t kernelSize, const float stdDev)
+    {
+        // blur straight into img's own buffer; borrowed pixels belong to
+        // someone else, so those still get a fresh image
+        if (img.empty() || img.borrowed())
+            return blurred(static_cast<const ImageT<T>&>(img), kernelSize, stdDev);
+
+        convolveSeparableT<T>(img.view(), img.view(), *gaussianKernel(kernelSize, stdDev));
+        return std::move(img);
+    }
+
+    template <typename T>
+    ImageT<T> blurredAnySigma(const ImageT<T>& img, const float stdDev)
+    {
+        if (stdDev >= boxBlurMinSigma)
+            return boxBlurGaussian(img, stdDev);
+
+        return blurred(img, gaussianKernelSize(stdDev), stdDev);
+    }
+}
+
+void imgproc::convolveSeparable(ConstImageView src, ImageView dst,
+    const Kernel& kernel)
+{
+    convolveSeparableT<uint8_t>(src, dst, kernel);
+}
+
+void imgproc::convolveSeparable(ConstImageView16 src, ImageView16 dst,
+    const Kernel& kernel)
+{
+    convolveSeparableT<uint16_t>(src, dst, kernel);
+}
+
+void imgproc::convolveSeparable(ConstImageViewF src, ImageViewF dst,
+    const Kernel& kernel)
+{
+    convolveSeparableT<float>(src, dst, kernel);
+}
+
+void imgproc::convolveSeparable(ConstImageView src, ImageView dst,
+    const PreparedKernel& kernel)
+{
+    convolveSeparableT<uint8_t>(src, dst, kernel);
+}
+
+void imgproc::convolveSeparable(ConstImageView16 src, ImageView16 dst,
+    const PreparedKernel& kernel)
+{
+    convolveSeparableT<uint16_t>(src, dst, kernel);
+}
+
+void imgproc::convolveSeparable(ConstImageViewF src, ImageViewF dst,
+    const PreparedKernel& kernel)
+{
+    convolveSeparableT<float>(src, dst, kernel);
+}
+
+imgproc::PreparedKernel imgproc::prepareKernel(Kernel kernel)
+{
+    PreparedKernel prepared;
+    if (!fixedPointKernel(kernel, prepared))
+    {
+        prepared.fixedHorizontal.clear();
+        prepared.fixedVertical.clear();
+    }
+    prepared.weights = std::move(kernel);
+    return prepared;
 }
 
- 
 imgproc::Image imgproc::applyGuassian(
     const Image& img, const uint8_t kernelSize,
     const float stdDev)
@@ -66,131 +617,232 @@ imgproc::Image imgproc::applyGuassian(
 	// - Using a 2D Guassian Kernel
 	// Optimized Implementation:
 	// - Break 2D Kernel into 2 seperable 1-D identical kernels
+	// - Stream rows through convolveSeparable so no padded copies are made
+
+    return blurred(img, kernelSize, stdDev);
+}
+
+imgproc::Image imgproc::applyGuassian(
+    Image&& img, const uint8_t kernelSize,
+    const float stdDev)
+{
+    return blurredInPlace(std::move(img), kernelSize, stdDev);
+}
 
-        
-    /*
-        original image:
-        XXXXX
-        XXXXX
-        XXXXX
+void imgproc::applyGuassian(ConstImageView src, ImageView dst,
+    const uint8_t kernelSize, const float stdDev)
+{
+    convolveSeparable(src, dst, *gaussianKernel(kernelSize, stdDev));
+}
 
-        3x3 kernel -> padded image by 1 on all sides:
-        PPPPPPP
-        PXXXXXP
-        PXXXXXP
-        PXXXXXP
-        PPPPPPP
+imgproc::Image16 imgproc::applyGuassian(const Image16& img,
+    const uint8_t kernelSize, const float stdDev)
+{
+    return blurred(img, kernelSize, stdDev);
+}
 
-        filtered image:
-        YYYYY
-        YYYYY
-        YYYYY
+imgproc::Image16 imgproc::applyGuassian(Image16&& img,
+    const uint8_t kernelSize, const float stdDev)
+{
+    return blurredInPlace(std::move(img), kernelSize, stdDev);
+}
 
-    */
+void imgproc::applyGuassian(ConstImageView16 src, ImageView16 dst,
+    const uint8_t kernelSize, const float stdDev)
+{
+    convolveSeparable(src, dst, *gaussianKernel(kernelSize, stdDev));
+}
 
-    // create copy of input image to return
-    Image gaussImg = img;
+imgproc::ImageF imgproc::applyGuassian(const ImageF& img,
+    const uint8_t kernelSize, const float stdDev)
+{
+    return blurred(img, kernelSize, stdDev);
+}
 
-    Image a = std::move(img);
-    // create kernel
-    Kernel kernel = computeKernel(kernelSize, stdDev);
+imgproc::ImageF imgproc::applyGuassian(ImageF&& img,
+    const uint8_t kernelSize, const float stdDev)
+{
+    return blurredInPlace(std::move(img), kernelSize, stdDev);
+}
 
-    // pad original image
-    int padEachSideBy = kernelSize / 2;
-    Image originalPadded = padImage(img, padEachSideBy);
+void imgproc::applyGuassian(ConstImageViewF src, ImageViewF dst,
+    const uint8_t kernelSize, const float stdDev)
+{
+    convolveSeparable(src, dst, *gaussianKernel(kernelSize, stdDev));
+}
 
-    // horizontal pass    
-    for (int y = 0; y < img.rows; y++)
-    {
-        for (int x = 0; x < img.cols; x++)
-        {
-            // for each pixel in padded image, convolve its neighbourhood with the kernel
-            float r{}, g{}, b{};
-            for (int k = -padEachSideBy; k <= padEachSideBy; k++)
-            {
-                // increment position by padding
-                // if original image position is (0,0) and padding is 1, then position 
-                // of that original position in the padded image is (1,1). Basically scaling 
-                Pixel originalPixel = originalPadded.getPixel(
-                    y + padEachSideBy, x + padEachSideBy + k);
-                r += kernel[k + padEachSideBy] * originalPixel.r;
-                g += kernel[k + padEachSideBy] * originalPixel.g;
-                b += kernel[k + padEachSideBy] * originalPixel.b;
-            }
+imgproc::Image imgproc::applyGuassian(const Image& img, const float stdDev)
+{
+    return blurredAnySigma(img, stdDev);
+}
 
-            Pixel newPixel;
-            newPixel.r = std::clamp<uint8_t>(r, 0, 255);
-            newPixel.g = std::clamp<uint8_t>(g, 0, 255);
-            newPixel.b = std::clamp<uint8_t>(b, 0, 255);
+imgproc::Image16 imgproc::applyGuassian(const Image16& img, const float stdDev)
+{
+    return blurredAnySigma(img, stdDev);
+}
 
-            gaussImg.setPixel(y, x, newPixel);
-        }
-    }
+imgproc::ImageF imgproc::applyGuassian(const ImageF& img, const float stdDev)
+{
+    return blurredAnySigma(img, stdDev);
+}
+
+imgproc::Image imgproc::applyGuassianGray(const Image& img,
+    const uint8_t kernelSize, const float stdDev)
+{
+    if (img.empty())
+        return Image{};
 
-    // pad horizontally-passed image to feed it to vertical pass
-    Image horizontalPassedPadded = padImage(gaussImg, padEachSideBy);
+    // the fused row conversion only reads 3-channel pixels
+    if (img.channels == 4)
+        return applyGuassian(bgrToGray(img), kernelSize, stdDev);
+    if (img.channels != 3)
+        return applyGuassian(img, kernelSize, stdDev);
 
-    // vertical pass    
-    for (int y = 0; y < img.rows; y++)
+    Image grayImg(img.rows, img.cols, 1, ImageInit::Uninitialized);
+    convolveSeparable(img.view(), grayImg.view(), *gaussianKernel(kernelSize, stdDev));
+
+    return grayImg;
+}
+
+namespace
+{
+    template <typename Buf, typename W>
+    void pyrDownT(ConstImageView src, ImageView dst,
+        const RowKernels<uint8_t, Buf, W>& kernels, const W* hKernel, const W* vKernel, int taps)
     {
-        for (int x = 0; x < img.cols; x++)
+        /*
+            same ring as convolveSeparable, but the ring only holds the even
+            columns of each filtered row and the vertical pass only runs for even
+            source rows, at the decimated width -- three quarters of the vertical
+            work and the full-size blurred image are never produced. the
+            horizontal pass still uses the SIMD row kernel over the whole row
+            (a strided scalar pass over just the even columns measured slower).
+        */
+
+        const int left = taps / 2;
+        const int right = taps - 1 - left;
+        const int rowElems = dst.rowElems();
+
+        parallelFor(0, dst.rows, [&](int yBegin, int yEnd)
         {
-            // for each pixel in padded image, convolve its neighbourhood with the kernel
-            float r{}, g{}, b{};
-            for (int k = -padEachSideBy; k <= padEachSideBy; k++)
+            Scratch<Buf> ring(static_cast<size_t>(taps) * rowElems);
+            Scratch<Buf> line(src.rowElems());
+            Scratch<const Buf*> window(taps);
+            auto ringRow = [&](int y) { return ring.data() + static_cast<size_t>(y % taps) * rowElems; };
+
+            int filteredUpTo = 0;
+            for (int y = yBegin; y < yEnd; y++)
             {
-                // increment 
-                Pixel originalPixel = horizontalPassedPadded.getPixel(
-                    y + padEachSideBy + k, x + padEachSideBy);
-                r += kernel[k + padEachSideBy] * originalPixel.r;
-                g += kernel[k + padEachSideBy] * originalPixel.g;
-                b += kernel[k + padEachSideBy] * originalPixel.b;
+                const int centre = 2 * y;
+                const int firstNeeded = std::max(0, centre - left);
+                const int lastNeeded = std::min(centre + right, src.rows - 1);
+                for (filteredUpTo = std::max(filteredUpTo, firstNeeded); filteredUpTo <= lastNeeded; filteredUpTo++)
+                {
+                    convolveRow(kernels, src.row(filteredUpTo), line.data(),
+                        src.cols, src.channels, hKernel, taps);
+                    decimateRow(line.data(), ringRow(filteredUpTo), dst.cols, src.channels);
+                }
+
+                const int kBegin = std::max(0, left - centre);
+                const int kEnd = std::min(taps, src.rows - centre + left);
+                for (int k = kBegin; k < kEnd; k++)
+                    window[k - kBegin] = ringRow(centre + k - left);
+
+                kernels.vertical(window.data(), vKernel + kBegin, kEnd - kBegin,
+                    dst.row(y), rowElems);
             }
+        }, std::max(8, 2 * taps));
+    }
+}
 
-            Pixel newPixel;
-            newPixel.r = std::clamp<uint8_t>(r, 0, 255);
-            newPixel.g = std::clamp<uint8_t>(g, 0, 255);
-            newPixel.b = std::clamp<uint8_t>(b, 0, 255);
-            
-            gaussImg.setPixel(y, x, newPixel);
-        }
+void imgproc::pyrDown(ConstImageView src, ImageView dst, const Kernel& kernel)
+{
+    pyrDown(src, dst, prepareKernel(kernel));
+}
+
+void imgproc::pyrDown(ConstImageView src, ImageView dst, const PreparedKernel& kernel)
+{
+    const int taps = static_cast<int>(kernel.weights.size());
+    if (src.empty() || dst.empty() || taps == 0)
+        return;
+
+    // the same row kernels and taps convolveSeparable picks for this kernel
+    if (!kernel.fixedHorizontal.empty())
+    {
+        const detail::FixedRowKernels k = detail::selectFixedRowKernels();
+        const RowKernels<uint8_t, uint16_t, uint16_t> kernels{ k.horizontal, k.vertical };
+        pyrDownT(src, dst, kernels, kernel.fixedHorizontal.data(), kernel.fixedVertical.data(), taps);
+        return;
     }
 
-    return gaussImg;
+    pyrDownT(src, dst, rowKernels<uint8_t>(), kernel.weights.data(), kernel.weights.data(), taps);
 }
 
 std::vector<imgproc::Image> 
-imgproc::getGuassianPyramid(const imgproc::Image& img)
+imgproc::getGuassianPyramid(const imgproc::Image& img, const PyramidOptions& options)
 {
     using namespace imgproc;
 
     std::vector<Image> pyramid; // L1, L2...
-	constexpr uint8_t minSize = 32;
 
 	if (img.empty())
 		return pyramid;
-	
-	pyramid.push_back(img);
 
-	while (pyramid.back().rows > minSize || pyramid.back().cols > minSize)
+	// level sizes are known up front, so size one block for all of them
+	std::vector<std::pair<int, int>> sizes{ { img.rows, img.cols } };
+	while ((sizes.back().first > options.minSize || sizes.back().second > options.minSize)
+		&& sizes.back().first > 1 && sizes.back().second > 1)
+		sizes.emplace_back(sizes.back().first / 2, sizes.back().second / 2);
+
+	// a gray pyramid converts straight into level 0; no colour level exists
+	const bool toGray = options.grayscale && img.channels == 3;
+	const int channels = toGray ? 1 : img.channels;
+
+	size_t total = 0;
+	for (const auto& [rows, cols] : sizes)
+		total += static_cast<size_t>(rows) * cols * channels;
+
+	auto block = std::make_shared<PixelBuffer>(total);
+	uint8_t* next = block->data();
+	for (const auto& [rows, cols] : sizes)
 	{
-		// always process next level from previous finer level
-		Image currPyrLevel = pyramid.back();
-		Image currPyrLevelBlurred = applyGuassian(currPyrLevel, 3, 1.6f);
-
-        Image nextPyrLevel(currPyrLevel.rows / 2, currPyrLevel.cols / 2, currPyrLevel.channels);
-
-		//  Old   New
-		// (0,0)  (0,0)
-		// (0,2)  (0,1)
-		// (0,4)  (0,2)
-		// (2,0)  (1, 0)
-		for (int y = 0; y < currPyrLevelBlurred.rows; y += 2)
-		{
-			for (int x = 0; x < currPyrLevelBlurred.cols; x += 2)
-                nextPyrLevel.setPixel(y / 2, x / 2, currPyrLevelBlurred.getPixel(y, x));
-		}
-		pyramid.push_back(nextPyrLevel);
+		const std::ptrdiff_t stride = static_cast<std::ptrdiff_t>(cols) * channels;
+		pyramid.emplace_back(ImageView(next, rows, cols, channels, stride), block);
+		next += stride * rows;
 	}
+
+	if (toGray)
+		bgrToGray(img.view(), pyramid[0].view());
+	else
+		embed(img.view(), pyramid[0].view(), 0, 0);
+
+	// always process next level from previous finer level
+	const auto kernel = gaussianKernel(options.kernelSize, options.stdDev);
+	for (size_t l = 1; l < pyramid.size(); l++)
+		pyrDown(pyramid[l - 1].view(), pyramid[l].view(), *kernel);
+
 	return pyramid;
-}
\ No newline at end of file
+}
+
+std::vector<std::vector<imgproc::Image>>
+imgproc::getGuassianPyramids(const std::vector<Image>& frames,
+    const PyramidOptions& options)
+{
+    std::vector<std::vector<Image>> pyramids(frames.size());
+
+    // a single frame keeps row-level parallelism inside pyrDown; otherwise
+    // each worker builds whole pyramids (the nested calls run serially)
+    if (frames.size() == 1)
+    {
+        pyramids[0] = getGuassianPyramid(frames[0], options);
+        return pyramids;
+    }
+
+    parallelFor(0, static_cast<int>(frames.size()), [&](int begin, int end)
+    {
+        for (int i = begin; i < end; i++)
+            pyramids[i] = getGuassianPyramid(frames[i], options);
+    });
+
+    return pyramids;
+}
@@ -4,14 +4,126 @@
 
 namespace imgproc
 {
+    // kernelSize 0 (in these and everywhere else a Gaussian takes one)
+    // picks gaussianKernelSize(stdDev). stdDev <= 0 is no blur: the result
+    // is a copy of the input, whatever kernelSize
     Image applyGuassian(const Image& img, const uint8_t kernelSize,
         const float stdDev);
+    // blurs in img's own buffer instead of allocating
+    Image applyGuassian(Image&& img, const uint8_t kernelSize,
+        const float stdDev);
+    // dst is src's size and may be src itself
+    void applyGuassian(ConstImageView src, ImageView dst,
+        const uint8_t kernelSize, const float stdDev);
+    // 16-bit and float images blur with the same engine; the float
+    // intermediate rows are kept as they are, so nothing is lost to uint8
+    Image16 applyGuassian(const Image16& img, const uint8_t kernelSize,
+        const float stdDev);
+    Image16 applyGuassian(Image16&& img, const uint8_t kernelSize,
+        const float stdDev);
+    void applyGuassian(ConstImageView16 src, ImageView16 dst,
+        const uint8_t kernelSize, const float stdDev);
+    ImageF applyGuassian(const ImageF& img, const uint8_t kernelSize,
+        const float stdDev);
+    ImageF applyGuassian(ImageF&& img, const uint8_t kernelSize,
+        const float stdDev);
+    void applyGuassian(ConstImageViewF src, ImageViewF dst,
+        const uint8_t kernelSize, const float stdDev);
+    // sigma alone: the exact kernel, ceil(6 sigma) taps rounded up to odd,
+    // below boxBlurMinSigma; from there on a 3-pass box cascade
+    // (boxBlurGaussian in boxBlur.h), whose cost does not grow with sigma.
+    // around sigma 10 the two cost about the same (61 taps)
+    constexpr float boxBlurMinSigma = 10.f;
+    Image applyGuassian(const Image& img, const float stdDev);
+    Image16 applyGuassian(const Image16& img, const float stdDev);
+    ImageF applyGuassian(const ImageF& img, const float stdDev);
+    // BGR or BGRA in, blurred gray out. BGR rows are converted as the blur
+    // reads them; BGRA is converted first. Other channel counts are blurred
+    // as they are
+    Image applyGuassianGray(const Image& img, const uint8_t kernelSize,
+        const float stdDev);
 
     Image padImage(const Image& img, const int padBy);
+    // dst must be (rows + 2 * padBy) x (cols + 2 * padBy)
+    void padImage(ConstImageView src, ImageView dst, const int padBy);
     
     using Kernel = std::vector<float>;
+    // normalised to sum to 1; stdDev <= 0 (or NaN) gives the 1-tap identity
+    // { 1 } for any kernelSize
     Kernel
     computeKernel(const uint8_t kernelSize, const float stdDev);
+
+    // ceil(6 sigma) rounded up to odd (+-3 sigma holds all but 0.3% of the
+    // weight), at most 255; 1 for stdDev <= 0 or NaN
+    uint8_t gaussianKernelSize(const float stdDev);
+
+    // A kernel together with the Q8/Q16 taps the uint8 fixed-point path
+    // runs on (see convolveSeparable); those are empty unless the kernel
+    // qualifies. uint16 and float images use weights as they are.
+    struct PreparedKernel
+    {
+        Kernel weights;
+        std::vector<uint16_t> fixedHorizontal;
+        std::vector<uint16_t> fixedVertical;
+    };
+    PreparedKernel prepareKernel(Kernel kernel);
+
+    // computeKernel(kernelSize, stdDev), prepared, from a process-wide cache
+    // keyed on both, so repeat blurs skip the exp()s and the quantizing.
+    // Safe to call from any thread; an entry stays valid for as long as it
+    // is held, even once the cache has dropped it.
+    std::shared_ptr<const PreparedKernel> gaussianKernel(const uint8_t kernelSize,
+        const float stdDev);
+
+    // Separable convolution of src into dst (same size and channels) with
+    // `kernel` applied along rows then columns. Borders read as black, matching
+    // padImage. Only kernel.size() filtered rows are buffered at a time.
+    // dst may be src itself (same view) to filter in place; no other overlap.
+    // A 3-channel src with a 1-channel dst converts BGR to gray on the fly
+    // (8-bit only).
+    // 8-bit images with a smoothing kernel (no negative taps, summing to 1)
+    // run in fixed point: the kernel is quantized to Q8 for the horizontal
+    // pass and Q16 for the vertical one, with one rounding at the end. The
+    // result is identical on every platform and within about one grey level
+    // of the float blur (cvfp_bench --accuracy).
+    void convolveSeparable(ConstImageView src, ImageView dst,
+        const Kernel& kernel);
+    void convolveSeparable(ConstImageView16 src, ImageView16 dst,
+        const Kernel& kernel);
+    void convolveSeparable(ConstImageViewF src, ImageViewF dst,
+        const Kernel& kernel);
+    // the same without preparing the kernel on every call
+    void convolveSeparable(ConstImageView src, ImageView dst,
+        const PreparedKernel& kernel);
+    void convolveSeparable(ConstImageView16 src, ImageView16 dst,
+        const PreparedKernel& kernel);
+    void convolveSeparable(ConstImageViewF src, ImageViewF dst,
+        const PreparedKernel& kernel);
   
-    std::vector<Image> getGuassianPyramid(const Image& img);
+    struct PyramidOptions
+    {
+        uint8_t kernelSize = 3; // 0: from stdDev
+        float stdDev = 1.6f;
+        // keep halving until neither side exceeds minSize
+        int minSize = 32;
+        // build from BGR -> gray straight into level 0
+        bool grayscale = false;
+    };
+
+    // Blur and 2x decimation in one pass: dst(y, x) = blur(src)(2y, 2x), with
+    // the same black borders as convolveSeparable. dst must be
+    // src.rows / 2 x src.cols / 2; only the surviving samples are filtered.
+    // Runs on the same fixed-point or float taps as convolveSeparable, so the
+    // samples match its output exactly.
+    void pyrDown(ConstImageView src, ImageView dst, const Kernel& kernel);
+    void pyrDown(ConstImageView src, ImageView dst, const PreparedKernel& kernel);
+
+    // Level 0 is a copy of img. Every level is a view into one block sized
+    // up front, which the levels keep alive between them.
+    std::vector<Image> getGuassianPyramid(const Image& img,
+        const PyramidOptions& options = {});
+
+    // one pyramid per frame, frames built concurrently
+    std::vector<std::vector<Image>> getGuassianPyramids(
+        const std::vector<Image>& frames, const PyramidOptions& options = {});
 }
@@ -0,0 +1,161 @@
+// Built with -mavx2; only called after cpuid reports AVX2.
+
+#include "GaussianFilter_simd.h"
+
+#ifdef IMGPROC_HAVE_AVX2
+
+#include <immintrin.h>
+
+#include <algorithm>
+
+namespace
+{
+    // 8 uint8 -> 8 floats
+    inline __m256 load8(const uint8_t* p)
+    {
+        const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+        return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+    }
+
+    // 16 uint8 -> 16 uint16
+    inline __m256i load16u16(const uint8_t* p)
+    {
+        return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+}
+
+void imgproc::detail::horizontalRowAVX2(const uint8_t* src, float* dst, int n,
+    int channels, const float* kernel, int taps)
+{
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256 lo = _mm256_setzero_ps();
+        __m256 hi = _mm256_setzero_ps();
+        for (int k = 0; k < taps; k++)
+        {
+            const __m256 w = _mm256_set1_ps(kernel[k]);
+            const uint8_t* p = src + i + k * channels;
+            lo = _mm256_add_ps(lo, _mm256_mul_ps(w, load8(p)));
+            hi = _mm256_add_ps(hi, _mm256_mul_ps(w, load8(p + 8)));
+        }
+        _mm256_storeu_ps(dst + i, lo);
+        _mm256_storeu_ps(dst + i + 8, hi);
+    }
+
+    for (; i < n; i++)
+    {
+        float acc{};
+        for (int k = 0; k < taps; k++)
+            acc += kernel[k] * src[i + k * channels];
+        dst[i] = acc;
+    }
+}
+
+void imgproc::detail::verticalRowAVX2(const float* const* rows, const float* kernel,
+    int taps, uint8_t* dst, int n)
+{
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 maxVal = _mm256_set1_ps(255.f);
+
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256 lo = _mm256_setzero_ps();
+        __m256 hi = _mm256_setzero_ps();
+        for (int k = 0; k < taps; k++)
+        {
+            const __m256 w = _mm256_set1_ps(kernel[k]);
+            lo = _mm256_add_ps(lo, _mm256_mul_ps(w, _mm256_loadu_ps(rows[k] + i)));
+            hi = _mm256_add_ps(hi, _mm256_mul_ps(w, _mm256_loadu_ps(rows[k] + i + 8)));
+        }
+
+        // round half up, clamp, truncate -- same as the scalar conversion
+        const __m256i loI = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_add_ps(lo, half), maxVal));
+        const __m256i hiI = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_add_ps(hi, half), maxVal));
+
+        // packs work per 128-bit lane; permute restores element order
+        const __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(loI, hiI), 0xD8);
+        const __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(words),
+            _mm256_extracti128_si256(words, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), bytes);
+    }
+
+    for (; i < n; i++)
+    {
+        float acc{};
+        for (int k = 0; k < taps; k++)
+            acc += kernel[k] * rows[k][i];
+        dst[i] = static_cast<uint8_t>(std::clamp(acc + 0.5f, 0.f, 255.f));
+    }
+}
+
+void imgproc::detail::horizontalRowFixedAVX2(const uint8_t* src, uint16_t* dst, int n,
+    int channels, const uint16_t* kernel, int taps)
+{
+    // Q8 weights sum to 256, so 16-bit lanes hold the whole sum
+    int i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i lo = _mm256_setzero_si256();
+        __m256i hi = _mm256_setzero_si256();
+        for (int k = 0; k < taps; k++)
+        {
+            const __m256i w = _mm256_set1_epi16(static_cast<short>(kernel[k]));
+            const uint8_t* p = src + i + k * channels;
+            lo = _mm256_add_epi16(lo, _mm256_mullo_epi16(w, load16u16(p)));
+            hi = _mm256_add_epi16(hi, _mm256_mullo_epi16(w, load16u16(p + 16)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 16), hi);
+    }
+
+    for (; i < n; i++)
+    {
+        uint32_t acc = 0;
+        for (int k = 0; k < taps; k++)
+            acc += kernel[k] * src[i + k * channels];
+        dst[i] = static_cast<uint16_t>(acc);
+    }
+}
+
+void imgproc::detail::verticalRowFixedAVX2(const uint16_t* const* rows, const uint16_t* kernel,
+    int taps, uint8_t* dst, int n)
+{
+    const __m256i half = _mm256_set1_epi32(1 << 23);
+
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        // the low and high halves of each 16 x 16 product, interleaved
+        // into 32-bit lanes (per 128-bit lane, undone by the pack below)
+        __m256i lo = _mm256_setzero_si256();
+        __m256i hi = _mm256_setzero_si256();
+        for (int k = 0; k < taps; k++)
+        {
+            const __m256i w = _mm256_set1_epi16(static_cast<short>(kernel[k]));
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k] + i));
+            const __m256i pLo = _mm256_mullo_epi16(v, w);
+            const __m256i pHi = _mm256_mulhi_epu16(v, w);
+            lo = _mm256_add_epi32(lo, _mm256_unpacklo_epi16(pLo, pHi));
+            hi = _mm256_add_epi32(hi, _mm256_unpackhi_epi16(pLo, pHi));
+        }
+
+        lo = _mm256_srli_epi32(_mm256_add_epi32(lo, half), 24);
+        hi = _mm256_srli_epi32(_mm256_add_epi32(hi, half), 24);
+        const __m256i words = _mm256_packus_epi32(lo, hi);
+        const __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(words),
+            _mm256_extracti128_si256(words, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), bytes);
+    }
+
+    for (; i < n; i++)
+    {
+        uint32_t acc = 1u << 23;
+        for (int k = 0; k < taps; k++)
+            acc += static_cast<uint32_t>(kernel[k]) * rows[k][i];
+        dst[i] = static_cast<uint8_t>(acc >> 24);
+    }
+}
+
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+
+// Row kernels behind convolveSeparable, one set per instruction set.
+// Internal to the Gaussian and Laplacian engines -- not part of the public
+// imgproc API.
+
+#include <cstdint>
+
+namespace imgproc::detail
+{
+    // dst[i] = sum_k kernel[k] * src[i + k * channels]   for i in [0, n)
+    // (src points at the first tap of element 0; every tap must be in range)
+    using HorizontalRowFn = void (*)(const uint8_t* src, float* dst, int n,
+        int channels, const float* kernel, int taps);
+
+    // dst[i] = round(sum_k kernel[k] * rows[k][i])   for i in [0, n)
+    using VerticalRowFn = void (*)(const float* const* rows, const float* kernel,
+        int taps, uint8_t* dst, int n);
+
+    struct SeparableRowKernels
+    {
+        HorizontalRowFn horizontal;
+        VerticalRowFn vertical;
+    };
+
+    // best kernels that were compiled in and are allowed by simdLevel()
+    SeparableRowKernels selectRowKernels();
+
+    // Fixed-point kernels for uint8. Horizontal weights are Q8 (summing to
+    // exactly 256), so a filtered row fits uint16 without overflow; vertical
+    // weights are Q16 (summing to 65536) and accumulate in 32 bits, leaving
+    // the result in Q24 for a single rounding shift.
+    // dst[i] = sum_k kernel[k] * src[i + k * channels]
+    using HorizontalRowFixedFn = void (*)(const uint8_t* src, uint16_t* dst, int n,
+        int channels, const uint16_t* kernel, int taps);
+
+    // dst[i] = (sum_k kernel[k] * rows[k][i] + 2^23) >> 24
+    using VerticalRowFixedFn = void (*)(const uint16_t* const* rows, const uint16_t* kernel,
+        int taps, uint8_t* dst, int n);
+
+    struct FixedRowKernels
+    {
+        HorizontalRowFixedFn horizontal;
+        VerticalRowFixedFn vertical;
+    };
+
+    FixedRowKernels selectFixedRowKernels();
+
+    // all variants accumulate in tap order with separate multiply and add,
+    // so they produce bit-identical output to the scalar path (the fixed-point
+    // ones are exact integer arithmetic, so identical on any platform)
+#ifdef IMGPROC_HAVE_SSE41
+    void horizontalRowSSE41(const uint8_t* src, float* dst, int n,
+        int channels, const float* kernel, int taps);
+    void verticalRowSSE41(const float* const* rows, const float* kernel,
+        int taps, uint8_t* dst, int n);
+    void horizontalRowFixedSSE41(const uint8_t* src, uint16_t* dst, int n,
+        int channels, const uint16_t* kernel, int taps);
+    void verticalRowFixedSSE41(const uint16_t* const* rows, const uint16_t* kernel,
+        int taps, uint8_t* dst, int n);
+#endif
+
+#ifdef IMGPROC_HAVE_AVX2
+    void horizontalRowAVX2(const uint8_t* src, float* dst, int n,
+        int channels, const float* kernel, int taps);
+    void verticalRowAVX2(const float* const* rows, const float* kernel,
+        int taps, uint8_t* dst, int n);
+    void horizontalRowFixedAVX2(const uint8_t* src, uint16_t* dst, int n,
+        int channels, const uint16_t* kernel, int taps);
+    void verticalRowFixedAVX2(const uint16_t* const* rows, const uint16_t* kernel,
+        int taps, uint8_t* dst, int n);
+#endif
+}
@@ -0,0 +1,157 @@
+// Built with -msse4.1; only called after cpuid reports SSE4.1.
+
+#include "GaussianFilter_simd.h"
+
+#ifdef IMGPROC_HAVE_SSE41
+
+#include <smmintrin.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // 4 uint8 -> 4 floats
+    inline __m128 load4(const uint8_t* p)
+    {
+        int32_t bytes;
+        std::memcpy(&bytes, p, sizeof(bytes));
+        return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes)));
+    }
+
+    // 8 uint8 -> 8 uint16
+    inline __m128i load8u16(const uint8_t* p)
+    {
+        return _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+    }
+}
+
+void imgproc::detail::horizontalRowSSE41(const uint8_t* src, float* dst, int n,
+    int channels, const float* kernel, int taps)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128 lo = _mm_setzero_ps();
+        __m128 hi = _mm_setzero_ps();
+        for (int k = 0; k < taps; k++)
+        {
+            const __m128 w = _mm_set1_ps(kernel[k]);
+            const uint8_t* p = src + i + k * channels;
+            lo = _mm_add_ps(lo, _mm_mul_ps(w, load4(p)));
+            hi = _mm_add_ps(hi, _mm_mul_ps(w, load4(p + 4)));
+        }
+        _mm_storeu_ps(dst + i, lo);
+        _mm_storeu_ps(dst + i + 4, hi);
+    }
+
+    for (; i < n; i++)
+    {
+        float acc{};
+        for (int k = 0; k < taps; k++)
+            acc += kernel[k] * src[i + k * channels];
+        dst[i] = acc;
+    }
+}
+
+void imgproc::detail::verticalRowSSE41(const float* const* rows, const float* kernel,
+    int taps, uint8_t* dst, int n)
+{
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 maxVal = _mm_set1_ps(255.f);
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128 lo = _mm_setzero_ps();
+        __m128 hi = _mm_setzero_ps();
+        for (int k = 0; k < taps; k++)
+        {
+            const __m128 w = _mm_set1_ps(kernel[k]);
+            lo = _mm_add_ps(lo, _mm_mul_ps(w, _mm_loadu_ps(rows[k] + i)));
+            hi = _mm_add_ps(hi, _mm_mul_ps(w, _mm_loadu_ps(rows[k] + i + 4)));
+        }
+
+        // round half up, clamp, truncate -- same as the scalar conversion
+        const __m128i loI = _mm_cvttps_epi32(_mm_min_ps(_mm_add_ps(lo, half), maxVal));
+        const __m128i hiI = _mm_cvttps_epi32(_mm_min_ps(_mm_add_ps(hi, half), maxVal));
+        const __m128i packed = _mm_packus_epi16(_mm_packus_epi32(loI, hiI), _mm_setzero_si128());
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), packed);
+    }
+
+    for (; i < n; i++)
+    {
+        float acc{};
+        for (int k = 0; k < taps; k++)
+            acc += kernel[k] * rows[k][i];
+        dst[i] = static_cast<uint8_t>(std::clamp(acc + 0.5f, 0.f, 255.f));
+    }
+}
+
+void imgproc::detail::horizontalRowFixedSSE41(const uint8_t* src, uint16_t* dst, int n,
+    int channels, const uint16_t* kernel, int taps)
+{
+    // Q8 weights sum to 256, so 16-bit lanes hold the whole sum
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i lo = _mm_setzero_si128();
+        __m128i hi = _mm_setzero_si128();
+        for (int k = 0; k < taps; k++)
+        {
+            const __m128i w = _mm_set1_epi16(static_cast<short>(kernel[k]));
+            const uint8_t* p = src + i + k * channels;
+            lo = _mm_add_epi16(lo, _mm_mullo_epi16(w, load8u16(p)));
+            hi = _mm_add_epi16(hi, _mm_mullo_epi16(w, load8u16(p + 8)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), hi);
+    }
+
+    for (; i < n; i++)
+    {
+        uint32_t acc = 0;
+        for (int k = 0; k < taps; k++)
+            acc += kernel[k] * src[i + k * channels];
+        dst[i] = static_cast<uint16_t>(acc);
+    }
+}
+
+void imgproc::detail::verticalRowFixedSSE41(const uint16_t* const* rows, const uint16_t* kernel,
+    int taps, uint8_t* dst, int n)
+{
+    const __m128i half = _mm_set1_epi32(1 << 23);
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        // the low and high halves of each 16 x 16 product, interleaved
+        // into 32-bit lanes
+        __m128i lo = _mm_setzero_si128();
+        __m128i hi = _mm_setzero_si128();
+        for (int k = 0; k < taps; k++)
+        {
+            const __m128i w = _mm_set1_epi16(static_cast<short>(kernel[k]));
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + i));
+            const __m128i pLo = _mm_mullo_epi16(v, w);
+            const __m128i pHi = _mm_mulhi_epu16(v, w);
+            lo = _mm_add_epi32(lo, _mm_unpacklo_epi16(pLo, pHi));
+            hi = _mm_add_epi32(hi, _mm_unpackhi_epi16(pLo, pHi));
+        }
+
+        lo = _mm_srli_epi32(_mm_add_epi32(lo, half), 24);
+        hi = _mm_srli_epi32(_mm_add_epi32(hi, half), 24);
+        const __m128i packed = _mm_packus_epi16(_mm_packus_epi32(lo, hi), _mm_setzero_si128());
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), packed);
+    }
+
+    for (; i < n; i++)
+    {
+        uint32_t acc = 1u << 23;
+        for (int k = 0; k < taps; k++)
+            acc += static_cast<uint32_t>(kernel[k]) * rows[k][i];
+        dst[i] = static_cast<uint8_t>(acc >> 24);
+    }
+}
+
+#endif
@@ -0,0 +1,364 @@
+// Summed-area tables and the box statistics built on them
+
+#include "IntegralImage.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+using namespace imgproc;
+
+namespace
+{
+    // rows [yBegin, yEnd) of a band, squares too unless squared is null
+    template <int C, typename S, typename Q>
+    void integralRows(ConstImageView src, int yBegin, int yEnd,
+        IntegralTable<S>& sum, IntegralTable<Q>* squared)
+    {
+        const int channels = C != 0 ? C : src.channels;
+        const int rowElems = src.rowElems();
+
+        for (int y = yBegin; y < yEnd; y++)
+        {
+            const uint8_t* in = src.row(y);
+            S* out = sum.row(y + 1) + channels;
+            // the band's first row is summed as if it were the image's
+            const S* above = y > yBegin ? sum.row(y) + channels : nullptr;
+
+            std::conditional_t<C != 0, std::array<S, C>, std::vector<S>> running{};
+            if constexpr (C == 0)
+                running.resize(channels);
+
+            for (int i = 0; i < rowElems; i += channels)
+                for (int c = 0; c < channels; c++)
+                {
+                    running[c] += in[i + c];
+                    out[i + c] = static_cast<S>(running[c] + (above ? above[i + c] : 0));
+                }
+
+            if (!squared)
+                continue;
+
+            Q* outSq = squared->row(y + 1) + channels;
+            const Q* aboveSq = y > yBegin ? squared->row(y) + channels : nullptr;
+            std::conditional_t<C != 0, std::array<Q, C>, std::vector<Q>> runningSq{};
+            if constexpr (C == 0)
+                runningSq.resize(channels);
+
+            for (int i = 0; i < rowElems; i += channels)
+                for (int c = 0; c < channels; c++)
+                {
+                    runningSq[c] += static_cast<Q>(in[i + c]) * in[i + c];
+                    outSq[i + c] = static_cast<Q>(runningSq[c] + (aboveSq ? aboveSq[i + c] : 0));
+                }
+        }
+    }
+
+    template <typename T>
+    void addRow(T* dst, const T* carry, int n)
+    {
+        for (int i = 0; i < n; i++)
+            dst[i] = static_cast<T>(dst[i] + carry[i]);
+    }
+
+    // every table row of band b > 0 gets the true last row of band b - 1;
+    // those last rows are fixed up first, top to bottom, the rest in parallel
+    template <typename T>
+    void carryBands(IntegralTable<T>& table, int bands, int bandRows)
+    {
+        const int n = static_cast<int>(table.stride());
+        for (int b = 1; b < bands; b++)
+            addRow(table.row(std::min(table.rows, (b + 1) * bandRows)), table.row(b * bandRows), n);
+
+        parallelFor(1, bands, [&](int bBegin, int bEnd)
+        {
+            for (int b = bBegin; b < bEnd; b++)
+            {
+                const int last = std::min(table.rows, (b + 1) * bandRows);
+                for (int y = b * bandRows + 1; y < last; y++)
+                    addRow(table.row(y), table.row(b * bandRows), n);
+            }
+        });
+    }
+
+    // the first row and column are never summed into, and a pooled
+    // buffer comes back holding whatever it last held
+    template <typename T>
+    void clearEdges(IntegralTable<T>& table)
+    {
+        std::fill(table.row(0), table.row(0) + table.stride(), T{});
+        for (int y = 1; y <= table.rows; y++)
+            std::fill(table.row(y), table.row(y) + table.channels, T{});
+    }
+
+    template <typename S, typename Q>
+    void buildIntegral(ConstImageView src, IntegralTable<S>& sum, IntegralTable<Q>* squared)
+    {
+        sum = IntegralTable<S>(src.rows, src.cols, src.channels);
+        clearEdges(sum);
+        if (squared)
+        {
+            *squared = IntegralTable<Q>(src.rows, src.cols, src.channels);
+            clearEdges(*squared);
+        }
+
+        // one band per thread; the carry pass costs a second write of
+        // every row below the first band, so more bands would only add to it
+        const int bands = std::max(1, std::min(getNumThreads(), src.rows / 64));
+        const int bandRows = (src.rows + bands - 1) / bands;
+
+        withChannels(src.channels, [&](auto count)
+        {
+            constexpr int C = decltype(count)::value;
+            parallelFor(0, bands, [&](int bBegin, int bEnd)
+            {
+                for (int b = bBegin; b < bEnd; b++)
+                    integralRows<C>(src, b * bandRows, std::min(src.rows, (b + 1) * bandRows),
+                        sum, squared);
+            });
+        });
+
+        carryBands(sum, bands, bandRows);
+        if (squared)
+            carryBands(*squared, bands, bandRows);
+    }
+
+    // S and Q as narrow as the window's largest sums allow: uint32 sums
+    // hold 16.7M pixels and uint32 squares 66K. Sums get headroom up to
+    // 256 * area, which boxFilter's rounding checks reach
+    template <typename F>
+    void withAccumulators(int radius, bool squares, F&& f)
+    {
+        const uint64_t area = static_cast<uint64_t>(2 * radius + 1) * (2 * radius + 1);
+        constexpr uint64_t max32 = std::numeric_limits<uint32_t>::max();
+        if (squares && area * 255 * 255 <= max32)
+            f(uint32_t{}, uint32_t{});
+        else if (area * 256 <= max32)
+            f(uint32_t{}, uint64_t{});
+        else
+            f(uint64_t{}, uint64_t{});
+    }
+
+    // rowSums[x * channels + c]: channel c summed over rows [y0, y1) and
+    // columns < x, so a window's sum is rowSums[x1 + c] - rowSums[x0 + c]
+    template <typename T>
+    void windowRowSums(const IntegralTable<T>& table, int y0, int y1, T* rowSums)
+    {
+        const T* top = table.row(y0);
+        const T* bottom = table.row(y1);
+        const int n = static_cast<int>(table.stride());
+        for (int i = 0; i < n; i++)
+            rowSums[i] = static_cast<T>(bottom[i] - top[i]);
+    }
+
+    // visit(i, lo, hi, area) for every element i = x * channels + c of an
+    // output row: the window's sum is rowSums[hi] - rowSums[lo], over
+    // `area` pixels of a window `height` rows tall. Windows are cut off at
+    // the left and right edges; in between they are all full width, so that
+    // loop is contiguous and vectorizes.
+    template <typename Visit>
+    void forEachWindowColumn(int cols, int channels, int radius, int height, const Visit& visit)
+    {
+        auto clipped = [&](int x)
+        {
+            const int begin = std::max(0, x - radius);
+            const int end = std::min(cols, x + radius + 1);
+            const int area = height * (end - begin);
+            for (int c = 0; c < channels; c++)
+                visit(x * channels + c, begin * channels + c, end * channels + c, area);
+        };
+
+        const int interiorBegin = std::min(radius, cols);
+        const int interiorEnd = std::max(interiorBegin, cols - radius);
+        for (int x = 0; x < interiorBegin; x++)
+            clipped(x);
+
+        const int area = height * (2 * radius + 1);
+        const int before = radius * channels;
+        const int after = (radius + 1) * channels;
+        for (int i = interiorBegin * channels; i < interiorEnd * channels; i++)
+            visit(i, i - before, i + after, area);
+
+        for (int x = interiorEnd; x < cols; x++)
+            clipped(x);
+    }
+
+    // body(y, height, rowSums) for every row, with rowSums over the rows of
+    // row y's window; rows spread over the threads
+    template <typename T, typename Body>
+    void forEachWindowRow(const IntegralTable<T>& table, int radius, const Body& body)
+    {
+        parallelFor(0, table.rows, [&](int yBegin, int yEnd)
+        {
+            std::vector<T> rowSums(table.stride());
+            for (int y = yBegin; y < yEnd; y++)
+            {
+                const int y0 = std::max(0, y - radius);
+                const int y1 = std::min(table.rows, y + radius + 1);
+                windowRowSums(table, y0, y1, rowSums.data());
+                body(y, y1 - y0, rowSums.data());
+            }
+        }, 8);
+    }
+}
+
+template <typename T>
+IntegralTable<T> imgproc::integral(ConstImageView src)
+{
+    IntegralTable<T> sum;
+    if (!src.empty())
+        buildIntegral<T, T>(src, sum, nullptr);
+    return sum;
+}
+
+template <typename T>
+IntegralTable<T> imgproc::squaredIntegral(ConstImageView src)
+{
+    IntegralTable<T> sum, squared;
+    if (!src.empty())
+        buildIntegral<T, T>(src, sum, &squared);
+    return squared;
+}
+
+template <typename S, typename Q>
+void imgproc::integral(ConstImageView src, IntegralTable<S>& sum, IntegralTable<Q>& squared)
+{
+    if (src.empty())
+    {
+        sum = IntegralTable<S>{};
+        squared = IntegralTable<Q>{};
+        return;
+    }
+    buildIntegral<S, Q>(src, sum, &squared);
+}
+
+template IntegralTable32 imgproc::integral<uint32_t>(ConstImageView);
+template IntegralTable64 imgproc::integral<uint64_t>(ConstImageView);
+template IntegralTable32 imgproc::squaredIntegral<uint32_t>(ConstImageView);
+template IntegralTable64 imgproc::squaredIntegral<uint64_t>(ConstImageView);
+template void imgproc::integral<uint32_t, uint32_t>(ConstImageView, IntegralTable32&, IntegralTable32&);
+template void imgproc::integral<uint32_t, uint64_t>(ConstImageView, IntegralTable32&, IntegralTable64&);
+template void imgproc::integral<uint64_t, uint64_t>(ConstImageView, IntegralTable64&, IntegralTable64&);
+
+Image imgproc::boxFilter(const Image& img, const int radius)
+{
+    if (img.empty() || radius < 0)
+        return Image{};
+
+    Image filtered(img.rows, img.cols, img.channels, ImageInit::Uninitialized);
+    boxFilter(img.view(), filtered.view(), radius);
+    return filtered;
+}
+
+void imgproc::boxFilter(ConstImageView src, ImageView dst, const int radius)
+{
+    if (src.empty() || radius < 0)
+        return;
+
+    withAccumulators(radius, false, [&](auto s, auto)
+    {
+        using S = decltype(s);
+        const IntegralTable<S> sum = integral<S>(src);
+
+        forEachWindowRow(sum, radius, [&](int y, int height, const S* rowSums)
+        {
+            uint8_t* out = dst.row(y);
+            forEachWindowColumn(src.cols, src.channels, radius, height,
+                [&](int i, int lo, int hi, int area)
+            {
+                // (total + area / 2) / area without a divide: the float
+                // quotient is at most one off, which the integer checks fix
+                const S n = static_cast<S>(area);
+                const S total = static_cast<S>(rowSums[hi] - rowSums[lo] + n / 2);
+                S q = static_cast<S>(static_cast<float>(total) / static_cast<float>(area));
+                if (q * n > total)
+                    q--;
+                else if ((q + 1) * n <= total)
+                    q++;
+                out[i] = static_cast<uint8_t>(q);
+            });
+        });
+    });
+}
+
+ImageF imgproc::localMean(const Image& img, const int radius)
+{
+    if (img.empty() || radius < 0)
+        return ImageF{};
+
+    ImageF mean(img.rows, img.cols, img.channels, ImageInit::Uninitialized);
+    withAccumulators(radius, false, [&](auto s, auto)
+    {
+        using S = decltype(s);
+        const IntegralTable<S> sum = integral<S>(img.view());
+
+        forEachWindowRow(sum, radius, [&](int y, int height, const S* rowSums)
+        {
+            float* out = mean.row(y);
+            forEachWindowColumn(img.cols, img.channels, radius, height,
+                [&](int i, int lo, int hi, int area)
+            {
+                out[i] = static_cast<float>(static_cast<S>(rowSums[hi] - rowSums[lo]))
+                    / static_cast<float>(area);
+            });
+        });
+    });
+    return mean;
+}
+
+ImageF imgproc::localVariance(const Image& img, const int radius)
+{
+    if (img.empty() || radius < 0)
+        return ImageF{};
+
+    ImageF mean(img.rows, img.cols, img.channels, ImageInit::Uninitialized);
+    ImageF variance(img.rows, img.cols, img.channels, ImageInit::Uninitialized);
+    localMeanVariance(img.view(), mean.view(), variance.view(), radius);
+    return variance;
+}
+
+void imgproc::localMeanVariance(ConstImageView src, ImageViewF mean, ImageViewF variance,
+    const int radius)
+{
+    if (src.empty() || radius < 0)
+        return;
+
+    withAccumulators(radius, true, [&](auto s, auto q)
+    {
+        using S = decltype(s);
+        using Q = decltype(q);
+        IntegralTable<S> sum;
+        IntegralTable<Q> squared;
+        integral(src, sum, squared);
+
+        parallelFor(0, src.rows, [&](int yBegin, int yEnd)
+        {
+            std::vector<S> rowSums(sum.stride());
+            std::vector<Q> rowSquares(squared.stride());
+            for (int y = yBegin; y < yEnd; y++)
+            {
+                const int y0 = std::max(0, y - radius);
+                const int y1 = std::min(src.rows, y + radius + 1);
+                windowRowSums(sum, y0, y1, rowSums.data());
+                windowRowSums(squared, y0, y1, rowSquares.data());
+
+                float* outMean = mean.row(y);
+                float* outVariance = variance.row(y);
+                forEachWindowColumn(src.cols, src.channels, radius, y1 - y0,
+                    [&](int i, int lo, int hi, int area)
+                {
+                    // in double: E[x^2] and E[x]^2 are up to 65025 and nearly
+                    // equal on flat areas, too close for float to subtract
+                    const double scale = 1.0 / area;
+                    const double m = static_cast<double>(static_cast<S>(rowSums[hi] - rowSums[lo])) * scale;
+                    const double m2 = static_cast<double>(static_cast<Q>(rowSquares[hi] - rowSquares[lo])) * scale;
+                    outMean[i] = static_cast<float>(m);
+                    outVariance[i] = static_cast<float>(std::max(0.0, m2 - m * m));
+                });
+            }
+        }, 8);
+    });
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "imgOps.h"
+
+namespace imgproc
+{
+    // Summed-area table of an 8-bit image: entry (y, x) holds, per channel,
+    // the sum over source rows < y and columns < x, so the table is
+    // (rows + 1) x (cols + 1) with a zero first row and column (OpenCV's
+    // layout) and any box sum is four lookups.
+    //
+    // T is uint32_t or uint64_t. Entries wrap around once the running sum
+    // passes T's range, but box sums are taken modulo 2^bits as well, so
+    // they stay exact as long as the box's own sum fits: with uint32_t, any
+    // box of up to 16.8M pixels for sums and 66K (257 x 257) for squared
+    // sums, whatever the image size.
+    template <typename T>
+    struct IntegralTable
+    {
+        int rows = 0; // of the source; the table has one more
+        int cols = 0;
+        int channels = 0;
+        std::vector<T, PoolAllocator<T>> data;
+
+        IntegralTable() = default;
+        IntegralTable(int _rows, int _cols, int _channels)
+        : rows(_rows), cols(_cols), channels(_channels),
+          data(static_cast<size_t>(_rows + 1) * (_cols + 1) * _channels) {}
+
+        bool empty() const { return data.empty(); }
+        std::ptrdiff_t stride() const { return static_cast<std::ptrdiff_t>(cols + 1) * channels; }
+        T* row(int y) { return data.data() + y * stride(); }
+        const T* row(int y) const { return data.data() + y * stride(); }
+
+        // sum of channel c over source rows [y0, y1) and columns [x0, x1)
+        T sum(int y0, int x0, int y1, int x1, int c = 0) const
+        {
+            const T* top = row(y0);
+            const T* bottom = row(y1);
+            return static_cast<T>(bottom[x1 * channels + c] - bottom[x0 * channels + c]
+                - top[x1 * channels + c] + top[x0 * channels + c]);
+        }
+    };
+
+    using IntegralTable32 = IntegralTable<uint32_t>;
+    using IntegralTable64 = IntegralTable<uint64_t>;
+
+    // Built in one pass over src: bands of rows are summed in parallel,
+    // each as if it were the top of the image, then every band is offset
+    // by the last row of the band above.
+    template <typename T>
+    IntegralTable<T> integral(ConstImageView src);
+    // sums of src squared
+    template <typename T>
+    IntegralTable<T> squaredIntegral(ConstImageView src);
+    // both, reading src once
+    template <typename S, typename Q>
+    void integral(ConstImageView src, IntegralTable<S>& sum, IntegralTable<Q>& squared);
+
+    // Window statistics over the (2 radius + 1)^2 pixels around each pixel,
+    // from the tables above, so the cost per pixel does not depend on the
+    // radius. Windows are cut off at the image edge and the statistics taken
+    // over what is left, rather than over a black border as in
+    // applyGuassian -- a border would drag edge means down and variances up.
+    // dst (mean, variance) is src's size and channels.
+
+    // the window mean, rounded
+    Image boxFilter(const Image& img, const int radius);
+    void boxFilter(ConstImageView src, ImageView dst, const int radius);
+
+    // unrounded, e.g. for local contrast normalization or adaptive thresholds
+    ImageF localMean(const Image& img, const int radius);
+    // E[x^2] - E[x]^2 over the window
+    ImageF localVariance(const Image& img, const int radius);
+    // mean and variance from one pair of tables
+    void localMeanVariance(ConstImageView src, ImageViewF mean, ImageViewF variance,
+        const int radius);
+}
@@ -0,0 +1,326 @@
+#include "LaplacianPyramid.h"
+#include "GaussianFilter.h"
+#include "GaussianFilter_simd.h"
+#include "colorConvert.h"
+#include "imgOps.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace imgproc;
+
+namespace
+{
+    // taps of expand() for every output position along one axis
+    struct ExpandTable
+    {
+        int taps = 0;
+        std::vector<int> index;
+        std::vector<float> weight;
+    };
+
+    ExpandTable expandTable(int coarseLen, int fineLen, const Kernel& kernel)
+    {
+        // fine position y sees the zero-inserted signal Z at y + k - left;
+        // only even positions 2j hold a coarse sample. which kernel taps
+        // land on samples alternates with y, so each phase is renormalised.
+        // unused slots repeat the last index with weight 0, keeping indices
+        // non-decreasing for the row ring in expandRows.
+        const int taps = static_cast<int>(kernel.size());
+        const int left = taps / 2;
+
+        ExpandTable table;
+        table.taps = (taps + 1) / 2;
+        table.index.assign(static_cast<size_t>(fineLen) * table.taps, 0);
+        table.weight.assign(static_cast<size_t>(fineLen) * table.taps, 0.f);
+
+        for (int y = 0; y < fineLen; y++)
+        {
+            int* index = &table.index[y * table.taps];
+            float* weight = &table.weight[y * table.taps];
+
+            int n = 0;
+            float sum{};
+            for (int k = 0; k < taps; k++)
+            {
+                const int z = y + k - left;
+                if (z & 1)
+                    continue;
+                index[n] = std::clamp(z / 2, 0, coarseLen - 1);
+                weight[n] = kernel[k];
+                sum += kernel[k];
+                n++;
+            }
+            for (int k = 0; k < n; k++)
+                weight[k] /= sum;
+            for (int k = n; k < table.taps; k++)
+                index[k] = index[n - 1];
+        }
+        return table;
+    }
+
+    // the two phases of expand() as ordinary kernels: away from the edges,
+    // fine position 2j + p reads coarse j + offset[p] onwards with weight[p]
+    struct ExpandPhases
+    {
+        int offset[2] = {};
+        Kernel weight[2];
+    };
+
+    ExpandPhases expandPhases(const Kernel& kernel)
+    {
+        const int taps = static_cast<int>(kernel.size());
+        const int left = taps / 2;
+
+        ExpandPhases phases;
+        for (int p = 0; p < 2; p++)
+        {
+            float sum{};
+            for (int k = 0; k < taps; k++)
+            {
+                const int z = p + k - left;
+                if (z & 1)
+                    continue;
+                if (phases.weight[p].empty())
+                    phases.offset[p] = (z - p) / 2;
+                phases.weight[p].push_back(kernel[k]);
+                sum += kernel[k];
+            }
+            for (float& w : phases.weight[p])
+                w /= sum;
+        }
+        return phases;
+    }
+
+    // interleave the even and odd phase rows into fine pixels [2 * jBegin, 2 * jEnd)
+    template <int C>
+    void interleave(const float* even, const float* odd, float* dst,
+        int jBegin, int jEnd, int channels = C)
+    {
+        if constexpr (C != 0)
+            channels = C;
+
+        for (int j = jBegin; j < jEnd; j++)
+            for (int c = 0; c < channels; c++)
+            {
+                dst[2 * j * channels + c] = even[j * channels + c];
+                dst[(2 * j + 1) * channels + c] = odd[j * channels + c];
+            }
+    }
+
+    // horizontal half of expand() over one coarse row into a float row
+    class RowExpander
+    {
+    public:
+        RowExpander(const Kernel& kernel, int coarseCols, int _fineCols, int _channels)
+        : table(expandTable(coarseCols, _fineCols, kernel)), phases(expandPhases(kernel)),
+          kernels(detail::selectRowKernels()), fineCols(_fineCols), channels(_channels)
+        {
+            // interior: both phases in range and both fine pixels exist
+            jBegin = std::max({ 0, -phases.offset[0], -phases.offset[1] });
+            jEnd = std::min({ _fineCols / 2,
+                coarseCols - phases.offset[0] - static_cast<int>(phases.weight[0].size()) + 1,
+                coarseCols - phases.offset[1] - static_cast<int>(phases.weight[1].size()) + 1 });
+            jEnd = std::max(jBegin, jEnd);
+        }
+
+        // even/odd are scratch rows of coarse width
+        void operator()(const uint8_t* src, float* dst, float* even, float* odd) const
+        {
+            const int n = (jEnd - jBegin) * channels;
+            if (n > 0)
+            {
+                float* phaseRows[2] = { even, odd };
+                for (int p = 0; p < 2; p++)
+                    kernels.horizontal(src + (jBegin + phases.offset[p]) * channels,
+                        phaseRows[p] + jBegin * channels, n, channels,
+                        phases.weight[p].data(), static_cast<int>(phases.weight[p].size()));
+
+                switch (channels)
+                {
+                case 1: interleave<1>(even, odd, dst, jBegin, jEnd); break;
+                case 3: interleave<3>(even, odd, dst, jBegin, jEnd); break;
+                case 4: interleave<4>(even, odd, dst, jBegin, jEnd); break;
+                default: interleave<0>(even, odd, dst, jBegin, jEnd, channels);
+                }
+            }
+
+            // edges, where taps clamp to the first/last coarse pixel
+            for (int x = 0; x < fineCols; x++)
+            {
+                if (x == 2 * jBegin && jEnd > jBegin)
+                    x = 2 * jEnd;
+                if (x >= fineCols)
+                    break;
+
+                const int* index = &table.index[x * table.taps];
+                const float* weight = &table.weight[x * table.taps];
+                for (int c = 0; c < channels; c++)
+                {
+                    float acc{};
+                    for (int k = 0; k < table.taps; k++)
+                        acc += weight[k] * src[index[k] * channels + c];
+                    dst[x * channels + c] = acc;
+                }
+            }
+        }
+
+    private:
+        ExpandTable table;
+        ExpandPhases phases;
+        detail::SeparableRowKernels kernels;
+        int fineCols;
+        int channels;
+        int jBegin = 0;
+        int jEnd = 0;
+    };
+
+    // expands coarse one fine row at a time and hands each row to
+    // emit(y, expandedRow) -- the upsampled image never exists in full.
+    // each coarse row is expanded horizontally once into a small ring of
+    // float rows; the vertical phase then runs on the SIMD row kernel.
+    template <typename Emit>
+    void expandRows(ConstImageView coarse, int fineRows, int fineCols,
+        const Kernel& kernel, const Emit& emit)
+    {
+        const ExpandTable rowTable = expandTable(coarse.rows, fineRows, kernel);
+        const RowExpander expandRow(kernel, coarse.cols, fineCols, coarse.channels);
+        const detail::SeparableRowKernels kernels = detail::selectRowKernels();
+        const int channels = coarse.channels;
+        const int fineElems = fineCols * channels;
+        const int ringSize = rowTable.taps + 1;
+
+        parallelFor(0, fineRows, [&](int yBegin, int yEnd)
+        {
+            std::vector<float> ring(static_cast<size_t>(ringSize) * fineElems);
+            std::vector<float> even(coarse.rowElems());
+            std::vector<float> odd(coarse.rowElems());
+            std::vector<const float*> window(rowTable.taps);
+            std::vector<uint8_t> expanded(fineElems);
+            auto ringRow = [&](int j) { return ring.data() + static_cast<size_t>(j % ringSize) * fineElems; };
+
+            int expandedUpTo = rowTable.index[yBegin * rowTable.taps];
+            for (int y = yBegin; y < yEnd; y++)
+            {
+                const int* index = &rowTable.index[y * rowTable.taps];
+                for (; expandedUpTo <= index[rowTable.taps - 1]; expandedUpTo++)
+                    expandRow(coarse.row(expandedUpTo), ringRow(expandedUpTo),
+                        even.data(), odd.data());
+
+                for (int k = 0; k < rowTable.taps; k++)
+                    window[k] = ringRow(index[k]);
+                kernels.vertical(window.data(), &rowTable.weight[y * rowTable.taps],
+                    rowTable.taps, expanded.data(), fineElems);
+
+                emit(y, expanded.data());
+            }
+        }, 16);
+    }
+
+    // same stopping rule as getGuassianPyramid
+    bool canHalve(int rows, int cols, const PyramidOptions& options)
+    {
+        return (rows > options.minSize || cols > options.minSize) && rows > 1 && cols > 1;
+    }
+}
+
+void imgproc::pyrUpSubtract(ConstImageView coarse, ConstImageView fine,
+    BandView band, const Kernel& kernel)
+{
+    if (coarse.empty() || fine.empty() || kernel.empty())
+        return;
+
+    const int rowElems = fine.rowElems();
+    expandRows(coarse, fine.rows, fine.cols, kernel,
+        [&](int y, const uint8_t* expanded)
+        {
+            const uint8_t* src = fine.row(y);
+            int16_t* dst = band.row(y);
+            for (int i = 0; i < rowElems; i++)
+                dst[i] = static_cast<int16_t>(src[i] - expanded[i]);
+        });
+}
+
+void imgproc::pyrUpAdd(ConstImageView coarse, ConstBandView band, ImageView fine,
+    const Kernel& kernel)
+{
+    if (coarse.empty() || fine.empty() || kernel.empty())
+        return;
+
+    const int rowElems = fine.rowElems();
+    expandRows(coarse, fine.rows, fine.cols, kernel,
+        [&](int y, const uint8_t* expanded)
+        {
+            const int16_t* src = band.row(y);
+            uint8_t* dst = fine.row(y);
+            for (int i = 0; i < rowElems; i++)
+                dst[i] = static_cast<uint8_t>(std::clamp(expanded[i] + src[i], 0, 255));
+        });
+}
+
+LaplacianPyramid imgproc::getLaplacianPyramid(const Image& img,
+    const PyramidOptions& options)
+{
+    LaplacianPyramid pyramid;
+    pyramid.options = options;
+
+    const std::vector<Image> gaussian = getGuassianPyramid(img, options);
+    if (gaussian.empty())
+        return pyramid;
+
+    const auto kernel = gaussianKernel(options.kernelSize, options.stdDev);
+    pyramid.bands.resize(gaussian.size() - 1);
+    for (size_t l = 0; l + 1 < gaussian.size(); l++)
+    {
+        const Image& fine = gaussian[l];
+        pyramid.bands[l] = LaplacianBand(fine.rows, fine.cols, fine.channels);
+        pyrUpSubtract(gaussian[l + 1].view(), fine.view(), pyramid.bands[l].view(), kernel->weights);
+    }
+
+    // own copy, so the Gaussian levels' shared block can be released
+    pyramid.residual = gaussian.back();
+    return pyramid;
+}
+
+Image imgproc::reconstruct(const LaplacianPyramid& pyramid)
+{
+    if (pyramid.residual.empty())
+        return Image{};
+
+    const auto kernel = gaussianKernel(pyramid.options.kernelSize, pyramid.options.stdDev);
+
+    // coarse to fine: each level only needs the one below it
+    Image current = pyramid.residual;
+    for (auto band = pyramid.bands.rbegin(); band != pyramid.bands.rend(); ++band)
+    {
+        Image finer(band->rows, band->cols, band->channels, ImageInit::Uninitialized);
+        pyrUpAdd(current.view(), band->view(), finer.view(), kernel->weights);
+        current = std::move(finer);
+    }
+    return current;
+}
+
+LaplacianBands::LaplacianBands(const Image& img, const PyramidOptions& _options)
+: current(_options.grayscale && img.channels == 3 ? bgrToGray(img) : img), options(_options),
+  kernel(gaussianKernel(_options.kernelSize, _options.stdDev)->weights)
+{
+}
+
+bool LaplacianBands::next(LaplacianBand& band)
+{
+    if (current.empty() || !canHalve(current.rows, current.cols, options))
+        return false;
+
+    Image coarse(current.rows / 2, current.cols / 2, current.channels,
+        ImageInit::Uninitialized);
+    pyrDown(current.view(), coarse.view(), kernel);
+
+    // reuse the caller's storage when the size matches
+    if (band.rows != current.rows || band.cols != current.cols || band.channels != current.channels)
+        band = LaplacianBand(current.rows, current.cols, current.channels);
+    pyrUpSubtract(coarse.view(), current.view(), band.view(), kernel);
+
+    current = std::move(coarse);
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "GaussianFilter.h"
+#include "imgOps.h"
+
+namespace imgproc
+{
+    using BandView = ImageViewT<int16_t>;
+    using ConstBandView = ImageViewT<const int16_t>;
+
+    // One level of detail: fine - expand(coarse). Signed 16-bit, so
+    // differences in [-255, 255] are kept exactly instead of clamped.
+    // Levels come from pyrDown, whose black borders show up as detail along
+    // the image edges; reconstruction is exact regardless.
+    struct LaplacianBand
+    {
+        int rows = 0;
+        int cols = 0;
+        int channels = 0;
+        std::vector<int16_t, PoolAllocator<int16_t>> data;
+
+        LaplacianBand() = default;
+        LaplacianBand(int _rows, int _cols, int _channels)
+        : rows(_rows), cols(_cols), channels(_channels),
+          data(static_cast<size_t>(_rows) * _cols * _channels) {}
+
+        bool empty() const { return data.empty(); }
+        int16_t* row(int y) { return data.data() + static_cast<size_t>(y) * cols * channels; }
+        const int16_t* row(int y) const { return data.data() + static_cast<size_t>(y) * cols * channels; }
+        BandView view() { return { data.data(), rows, cols, channels, static_cast<std::ptrdiff_t>(cols) * channels }; }
+        ConstBandView view() const { return { data.data(), rows, cols, channels, static_cast<std::ptrdiff_t>(cols) * channels }; }
+    };
+
+    // expand(coarse) is a 2x upsample: zero insertion followed by `kernel`,
+    // with the taps of each output phase renormalised so flat areas stay
+    // flat for any kernel; coarse edges replicate. Both kernels compute one
+    // expanded row at a time and never materialise the upsampled image.
+
+    // band = fine - expand(coarse); fine is coarse's finer level
+    void pyrUpSubtract(ConstImageView coarse, ConstImageView fine,
+        BandView band, const Kernel& kernel);
+
+    // fine = clamp(expand(coarse) + band)
+    void pyrUpAdd(ConstImageView coarse, ConstBandView band, ImageView fine,
+        const Kernel& kernel);
+
+    struct LaplacianPyramid
+    {
+        std::vector<LaplacianBand> bands; // finest first
+        Image residual;                   // coarsest Gaussian level
+        PyramidOptions options;
+    };
+
+    LaplacianPyramid getLaplacianPyramid(const Image& img,
+        const PyramidOptions& options = {});
+
+    // exact inverse of getLaplacianPyramid for unmodified bands
+    Image reconstruct(const LaplacianPyramid& pyramid);
+
+    // Yields bands finest first while holding only two Gaussian levels, for
+    // when the whole pyramid does not need to be resident:
+    //
+    //   LaplacianBands bands(img);
+    //   LaplacianBand band;
+    //   while (bands.next(band))
+    //       process(band);
+    //   process(bands.residual());
+    class LaplacianBands
+    {
+    public:
+        explicit LaplacianBands(const Image& img, const PyramidOptions& options = {});
+
+        // false once only the residual is left
+        bool next(LaplacianBand& band);
+
+        // coarsest level; complete after next() returned false
+        const Image& residual() const { return current; }
+
+    private:
+        Image current;
+        PyramidOptions options;
+        Kernel kernel;
+    };
+}
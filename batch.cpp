@@ -0,0 +1,723 @@
+// cvfp_batch: runs a pipeline over many image files without a display.
+//
+//   cvfp_batch --pipeline "gray,blur:5:1.4,scale:0.5,rotate:30" --out dir
+//              [--workers n] [--io n] [--ext png] [--list file|-] inputs...
+//
+// inputs are image files or directories (the images directly inside them);
+// --list adds one path per line from a file or stdin. Every result is
+// written to dir under its input's file name, with the extension swapped
+// for --ext when given.
+//
+// .cvraw raw frames (imageIO.h) are mapped without decoding and written
+// without encoding, and 8-bit .pgm/.ppm skip OpenCV too (a .pgm input stays
+// one channel); use them for intermediate results that are read back.
+//
+// Decoding, processing and encoding are three stages joined by bounded
+// queues, so the next file is read and the previous one written while the
+// current one is processed. --io sets the decoder and the encoder threads
+// (each); --workers how many images are processed at once. With several
+// workers every image runs single-threaded -- whole images are the unit of
+// parallelism -- while --workers 1 gives each image the full thread pool.
+//
+// pipeline steps, comma separated, arguments after ':'
+//   gray                               BGR -> gray
+//   blur:k[:sigma]                     Gaussian with odd k; sigma defaults to
+//                                      0.3 * ((k - 1) / 2 - 1) + 0.8 (OpenCV's rule)
+//   scale:f[:nn|bilinear|area]         uniform scale, bilinear by default
+//   resize:WxH[:nn|bilinear|area]
+//   rotate:deg[:nn|bilinear|bicubic]   CCW, canvas grows to fit; bilinear by default
+//   translate:tx:ty
+//   brightness:b  contrast:a  gamma:g  invert
+// Runs of point ops collapse into one lookup table, and gray straight before
+// blur becomes the fused gray blur, so "gray,blur:5" reads the colour image once.
+//
+// At the end the time spent in each stage and pipeline step is printed,
+// summed over the threads running it (so stages can add up to more than the
+// wall time), together with how long workers sat waiting for decoded images.
+// Exits 1 on bad arguments and 2 if any image failed.
+
+#include "GaussianFilter.h"
+#include "colorConvert.h"
+#include "cvInterop.h"
+#include "imageIO.h"
+#include "imgOps.h"
+#include "parallel.h"
+#include "pointLut.h"
+#include "rotate.h"
+#include "scale.h"
+#include "translate.h"
+#include "warp.h"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace imgproc;
+namespace fs = std::filesystem;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // ---------------------------------------------------------------------------
+    // pipeline spec
+
+    struct Step
+    {
+        std::string label;
+        std::function<Image(Image&&)> run;
+    };
+
+    std::vector<std::string> split(const std::string& s, char sep)
+    {
+        std::vector<std::string> parts;
+        size_t begin = 0;
+        for (size_t end; (end = s.find(sep, begin)) != std::string::npos; begin = end + 1)
+            parts.push_back(s.substr(begin, end - begin));
+        parts.push_back(s.substr(begin));
+        return parts;
+    }
+
+    bool parseNumber(const std::string& s, double& value)
+    {
+        if (s.empty())
+            return false;
+        char* end;
+        value = std::strtod(s.c_str(), &end);
+        return *end == '\0' && std::isfinite(value);
+    }
+
+    bool parseInt(const std::string& s, int& value)
+    {
+        double v;
+        if (!parseNumber(s, v) || v != std::floor(v) || std::abs(v) > 1e9)
+            return false;
+        value = static_cast<int>(v);
+        return true;
+    }
+
+    bool parseScaling(const std::string& s, Scale::InterpolationMethod& method)
+    {
+        if (s == "nn")
+            method = Scale::InterpolationMethod::NearestNeighbour;
+        else if (s == "bilinear")
+            method = Scale::InterpolationMethod::Bilinear;
+        else if (s == "area")
+            method = Scale::InterpolationMethod::Area;
+        else
+            return false;
+        return true;
+    }
+
+    bool parseInterpolation(const std::string& s, Interpolation& interpolation)
+    {
+        if (s == "nn")
+            interpolation = Interpolation::NearestNeighbour;
+        else if (s == "bilinear")
+            interpolation = Interpolation::Bilinear;
+        else if (s == "bicubic")
+            interpolation = Interpolation::Bicubic;
+        else
+            return false;
+        return true;
+    }
+
+    bool isPointOp(const std::string& op)
+    {
+        return op == "brightness" || op == "contrast" || op == "gamma" || op == "invert";
+    }
+
+    // spec -> steps; on failure error says which step was wrong
+    bool parsePipeline(const std::string& spec, std::vector<Step>& steps, std::string& error)
+    {
+        steps.clear();
+        if (spec.empty())
+            return true;
+
+        // pending run of point ops, folded into one table
+        PointLut lut;
+        std::string lutLabel;
+        auto flushLut = [&]
+        {
+            if (lutLabel.empty())
+                return;
+            steps.push_back({ lutLabel, [lut](Image&& img)
+            {
+                lut.applyInPlace(img);
+                return std::move(img);
+            } });
+            lut = PointLut();
+            lutLabel.clear();
+        };
+
+        bool lastWasGray = false;
+        for (const std::string& token : split(spec, ','))
+        {
+            const std::vector<std::string> args = split(token, ':');
+            const std::string& op = args[0];
+            const size_t n = args.size() - 1;
+            auto fail = [&](const char* why)
+            {
+                error = "'" + token + "': " + why;
+                return false;
+            };
+
+            if (isPointOp(op))
+            {
+                double v = 0;
+                if (op == "invert")
+                {
+                    if (n != 0)
+                        return fail("takes no arguments");
+                    lut.invert();
+                }
+                else if (n != 1 || !parseNumber(args[1], v))
+                    return fail("expects one number");
+                else if (op == "brightness")
+                {
+                    int beta;
+                    if (!parseInt(args[1], beta))
+                        return fail("expects an integer");
+                    lut.brightness(beta);
+                }
+                else if (op == "contrast")
+                {
+                    if (v < 0)
+                        return fail("needs a factor >= 0");
+                    lut.contrast(static_cast<float>(v));
+                }
+                else
+                {
+                    if (v <= 0)
+                        return fail("needs a gamma > 0");
+                    lut.gamma(static_cast<float>(v));
+                }
+                lutLabel += (lutLabel.empty() ? "" : "+") + token;
+                lastWasGray = false;
+                continue;
+            }
+            flushLut();
+
+            if (op == "gray")
+            {
+                if (n != 0)
+                    return fail("takes no arguments");
+                steps.push_back({ token, [](Image&& img)
+                {
+                    return img.channels == 3 || img.channels == 4 ? bgrToGray(img) : std::move(img);
+                } });
+                lastWasGray = true;
+                continue;
+            }
+
+            if (op == "blur")
+            {
+                int k;
+                double sigma;
+                if (n < 1 || n > 2 || !parseInt(args[1], k))
+                    return fail("expects blur:k[:sigma]");
+                if (k < 1 || k > 255 || k % 2 == 0)
+                    return fail("kernel size must be odd and at most 255");
+                sigma = 0.3 * ((k - 1) * 0.5 - 1) + 0.8;
+                if (n == 2 && (!parseNumber(args[2], sigma) || sigma <= 0))
+                    return fail("sigma must be > 0");
+
+                const uint8_t size = static_cast<uint8_t>(k);
+                const float sd = static_cast<float>(sigma);
+                if (lastWasGray)
+                {
+                    // replaces the gray step before it
+                    Step& fused = steps.back();
+                    fused.label += "+" + token;
+                    fused.run = [size, sd](Image&& img)
+                    {
+                        return img.channels == 3 || img.channels == 4 ? applyGuassianGray(img, size, sd)
+                                                                      : applyGuassian(std::move(img), size, sd);
+                    };
+                }
+                else
+                    steps.push_back({ token, [size, sd](Image&& img)
+                    {
+                        return applyGuassian(std::move(img), size, sd);
+                    } });
+            }
+            else if (op == "scale")
+            {
+                double factor;
+                Scale::InterpolationMethod method = Scale::InterpolationMethod::Bilinear;
+                if (n < 1 || n > 2 || !parseNumber(args[1], factor) || factor <= 0)
+                    return fail("expects scale:factor[:nn|bilinear|area] with factor > 0");
+                if (n == 2 && !parseScaling(args[2], method))
+                    return fail("unknown interpolation");
+                steps.push_back({ token, [factor, method](Image&& img)
+                {
+                    return Scale::scale(img, method, factor);
+                } });
+            }
+            else if (op == "resize")
+            {
+                int cols = 0, rows = 0, used = 0;
+                Scale::InterpolationMethod method = Scale::InterpolationMethod::Bilinear;
+                if (n < 1 || n > 2
+                    || std::sscanf(args[1].c_str(), "%dx%d%n", &cols, &rows, &used) != 2
+                    || used != static_cast<int>(args[1].size()) || cols <= 0 || rows <= 0)
+                    return fail("expects resize:WxH[:nn|bilinear|area]");
+                if (n == 2 && !parseScaling(args[2], method))
+                    return fail("unknown interpolation");
+                steps.push_back({ token, [rows, cols, method](Image&& img)
+                {
+                    return Scale::resize(img, rows, cols, method);
+                } });
+            }
+            else if (op == "rotate")
+            {
+                double angle;
+                Interpolation interpolation = Interpolation::Bilinear;
+                if (n < 1 || n > 2 || !parseNumber(args[1], angle))
+                    return fail("expects rotate:degrees[:nn|bilinear|bicubic]");
+                if (n == 2 && !parseInterpolation(args[2], interpolation))
+                    return fail("unknown interpolation");
+                steps.push_back({ token, [angle, interpolation](Image&& img)
+                {
+                    return Rotation::rotate(img, angle, Rotation::rotateMethod::INV_MAP, interpolation);
+                } });
+            }
+            else if (op == "translate")
+            {
+                int tx, ty;
+                if (n != 2 || !parseInt(args[1], tx) || !parseInt(args[2], ty))
+                    return fail("expects translate:tx:ty");
+                steps.push_back({ token, [tx, ty](Image&& img)
+                {
+                    return translate(std::move(img), tx, ty);
+                } });
+            }
+            else
+                return fail(op.empty() ? "empty step" : "unknown step");
+
+            lastWasGray = false;
+        }
+        flushLut();
+        return true;
+    }
+
+    // ---------------------------------------------------------------------------
+    // stages
+
+    // FIFO between two stages. push blocks while full, which keeps decoders
+    // from running arbitrarily far ahead of slow workers; pop returns false
+    // once the queue is closed and drained.
+    template <typename T>
+    class BoundedQueue
+    {
+    public:
+        explicit BoundedQueue(size_t _capacity) : capacity(_capacity) {}
+
+        void push(T item)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            notFull.wait(lock, [&] { return items.size() < capacity; });
+            items.push_back(std::move(item));
+            notEmpty.notify_one();
+        }
+
+        bool pop(T& item)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [&] { return !items.empty() || closed; });
+            if (items.empty())
+                return false;
+            item = std::move(items.front());
+            items.pop_front();
+            notFull.notify_one();
+            return true;
+        }
+
+        // no more pushes; wakes everyone waiting in pop
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+            notEmpty.notify_all();
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable notEmpty;
+        std::condition_variable notFull;
+        std::deque<T> items;
+        size_t capacity;
+        bool closed = false;
+    };
+
+    struct Job
+    {
+        size_t index = 0;
+        Image img;
+    };
+
+    // nanoseconds accumulated from any number of threads
+    struct Timer
+    {
+        std::atomic<int64_t> ns{ 0 };
+
+        void add(Clock::time_point since)
+        {
+            ns += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count();
+        }
+        double seconds() const { return ns.load() * 1e-9; }
+    };
+
+    // ---------------------------------------------------------------------------
+    // command line
+
+    struct Options
+    {
+        std::string pipeline;
+        fs::path out;
+        std::string ext;
+        int workers = 0;
+        int io = 1;
+        std::vector<std::string> inputs;
+        std::string list;
+    };
+
+    std::string lowerExtension(const fs::path& path)
+    {
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(),
+            [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return ext;
+    }
+
+    bool hasImageExtension(const fs::path& path)
+    {
+        static const std::set<std::string> extensions{ ".bmp", ".cvraw", ".dib", ".exr", ".hdr",
+            ".jp2", ".jpe", ".jpeg", ".jpg", ".pbm", ".pfm", ".pgm", ".pic", ".png", ".pnm",
+            ".ppm", ".pxm", ".ras", ".sr", ".tif", ".tiff", ".webp" };
+        return extensions.count(lowerExtension(path)) != 0;
+    }
+
+    // raw frames are mapped, not decoded, and 8-bit PGM/PPM are read
+    // without OpenCV; the rest goes through imread
+    Image readImage(const fs::path& path)
+    {
+        const std::string ext = lowerExtension(path);
+        if (ext == ".cvraw")
+            return mapRawFrame<uint8_t>(path.string());
+        if (ext == ".pgm" || ext == ".ppm")
+        {
+            Image img = readPnm(path.string());
+            if (!img.empty())
+                return img;
+        }
+        // the Image borrows the decoder's buffer; no copy
+        return wrapMat(cv::imread(path.string(), cv::IMREAD_COLOR));
+    }
+
+    bool writeImage(const fs::path& path, const Image& img)
+    {
+        const std::string ext = lowerExtension(path);
+        if (ext == ".cvraw")
+            return writeRawFrame(path.string(), img);
+        if ((ext == ".pgm" && img.channels == 1) || (ext == ".ppm" && img.channels == 3))
+            return writePnm(path.string(), img);
+        try
+        {
+            return cv::imwrite(path.string(), imgToMat(img));
+        }
+        catch (const cv::Exception&)
+        {
+            return false;
+        }
+    }
+
+    // files as given, directories expanded to the images directly inside them
+    bool collectInputs(const Options& options, std::vector<fs::path>& inputs)
+    {
+        std::vector<std::string> paths = options.inputs;
+        if (!options.list.empty())
+        {
+            std::ifstream file;
+            if (options.list != "-")
+            {
+                file.open(options.list);
+                if (!file)
+                {
+                    std::fprintf(stderr, "cvfp_batch: cannot open list %s\n", options.list.c_str());
+                    return false;
+                }
+            }
+            std::istream& in = options.list == "-" ? std::cin : file;
+            for (std::string line; std::getline(in, line);)
+            {
+                while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+                    line.pop_back();
+                if (!line.empty())
+                    paths.push_back(line);
+            }
+        }
+
+        for (const std::string& p : paths)
+        {
+            std::error_code ec;
+            if (!fs::is_directory(p, ec))
+            {
+                inputs.emplace_back(p);
+                continue;
+            }
+
+            std::vector<fs::path> found;
+            for (const fs::directory_entry& entry : fs::directory_iterator(p, ec))
+                if (entry.is_regular_file(ec) && hasImageExtension(entry.path()))
+                    found.push_back(entry.path());
+            if (ec)
+            {
+                std::fprintf(stderr, "cvfp_batch: cannot list %s: %s\n", p.c_str(), ec.message().c_str());
+                return false;
+            }
+            std::sort(found.begin(), found.end());
+            inputs.insert(inputs.end(), found.begin(), found.end());
+        }
+        return true;
+    }
+
+    bool parseArgs(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--pipeline" && hasValue)
+                options.pipeline = argv[++i];
+            else if (arg == "--out" && hasValue)
+                options.out = argv[++i];
+            else if (arg == "--ext" && hasValue)
+            {
+                options.ext = argv[++i];
+                if (!options.ext.empty() && options.ext[0] != '.')
+                    options.ext.insert(0, ".");
+            }
+            else if (arg == "--workers" && hasValue)
+                options.workers = std::atoi(argv[++i]);
+            else if (arg == "--io" && hasValue)
+                options.io = std::atoi(argv[++i]);
+            else if (arg == "--list" && hasValue)
+                options.list = argv[++i];
+            else if (!arg.empty() && arg[0] == '-')
+                return false;
+            else
+                options.inputs.push_back(arg);
+        }
+        return !options.out.empty() && options.io > 0 && options.workers >= 0
+            && (!options.inputs.empty() || !options.list.empty());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseArgs(argc, argv, options))
+    {
+        std::fprintf(stderr, "usage: %s --pipeline spec --out dir [--workers n] [--io n] "
+            "[--ext png] [--list file|-] inputs...\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<Step> steps;
+    std::string error;
+    if (!parsePipeline(options.pipeline, steps, error))
+    {
+        std::fprintf(stderr, "cvfp_batch: bad pipeline step %s\n", error.c_str());
+        return 1;
+    }
+
+    std::vector<fs::path> inputs;
+    if (!collectInputs(options, inputs))
+        return 1;
+    if (inputs.empty())
+    {
+        std::fprintf(stderr, "cvfp_batch: no input images\n");
+        return 1;
+    }
+
+    // refuse up front rather than have two inputs overwrite one output, or
+    // an output overwrite an input (perhaps one not yet read); paths are
+    // compared resolved, so "dir/a.png" and "./dir/a.png" are the same file
+    auto resolved = [](const fs::path& p)
+    {
+        std::error_code ec;
+        const fs::path full = fs::weakly_canonical(p, ec);
+        return ec ? p.lexically_normal() : full;
+    };
+    std::set<fs::path> sources;
+    for (const fs::path& in : inputs)
+        sources.insert(resolved(in));
+
+    std::vector<fs::path> outputs;
+    std::set<fs::path> taken;
+    for (const fs::path& in : inputs)
+    {
+        fs::path name = in.filename();
+        if (!options.ext.empty())
+            name.replace_extension(options.ext);
+        outputs.push_back(options.out / name);
+        const fs::path target = resolved(outputs.back());
+        if (sources.count(target))
+        {
+            std::fprintf(stderr, "cvfp_batch: %s is also an input; pick another --out or --ext\n",
+                outputs.back().c_str());
+            return 1;
+        }
+        if (!taken.insert(target).second)
+        {
+            std::fprintf(stderr, "cvfp_batch: more than one input would be written to %s\n",
+                outputs.back().c_str());
+            return 1;
+        }
+    }
+
+    std::error_code ec;
+    fs::create_directories(options.out, ec);
+    if (ec)
+    {
+        std::fprintf(stderr, "cvfp_batch: cannot create %s: %s\n", options.out.c_str(), ec.message().c_str());
+        return 1;
+    }
+
+    const int workers = options.workers > 0 ? options.workers : getNumThreads();
+    if (workers > 1)
+        setNumThreads(1);
+
+    BoundedQueue<Job> decoded(2 * workers);
+    BoundedQueue<Job> processed(2 * workers);
+
+    std::atomic<size_t> nextInput{ 0 };
+    std::atomic<int> decodersLeft{ options.io };
+    std::atomic<int> workersLeft{ workers };
+    std::atomic<size_t> written{ 0 };
+    std::atomic<size_t> failed{ 0 };
+    std::atomic<int64_t> pixels{ 0 };
+
+    Timer decodeTime, processTime, encodeTime, idleTime;
+    std::vector<Timer> stepTimes(steps.size());
+
+    auto reportFailure = [&](const char* what, const fs::path& path)
+    {
+        failed++;
+        std::fprintf(stderr, "cvfp_batch: cannot %s %s\n", what, path.c_str());
+    };
+
+    const Clock::time_point start = Clock::now();
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < options.io; t++)
+        threads.emplace_back([&]
+        {
+            for (size_t i; (i = nextInput++) < inputs.size();)
+            {
+                const Clock::time_point t0 = Clock::now();
+                Image img = readImage(inputs[i]);
+                decodeTime.add(t0);
+                if (img.empty())
+                {
+                    reportFailure("read", inputs[i]);
+                    continue;
+                }
+                pixels += static_cast<int64_t>(img.rows) * img.cols;
+                decoded.push({ i, std::move(img) });
+            }
+            if (--decodersLeft == 0)
+                decoded.close();
+        });
+
+    for (int t = 0; t < workers; t++)
+        threads.emplace_back([&]
+        {
+            Job job;
+            for (;;)
+            {
+                const Clock::time_point waitStart = Clock::now();
+                if (!decoded.pop(job))
+                    break;
+                idleTime.add(waitStart);
+
+                const Clock::time_point t0 = Clock::now();
+                for (size_t s = 0; s < steps.size() && !job.img.empty(); s++)
+                {
+                    const Clock::time_point stepStart = Clock::now();
+                    job.img = steps[s].run(std::move(job.img));
+                    stepTimes[s].add(stepStart);
+                }
+                processTime.add(t0);
+
+                if (job.img.empty())
+                    reportFailure("process", inputs[job.index]);
+                else
+                    processed.push(std::move(job));
+            }
+            if (--workersLeft == 0)
+                processed.close();
+        });
+
+    for (int t = 0; t < options.io; t++)
+        threads.emplace_back([&]
+        {
+            Job job;
+            while (processed.pop(job))
+            {
+                const Clock::time_point t0 = Clock::now();
+                const bool ok = writeImage(outputs[job.index], job.img);
+                encodeTime.add(t0);
+
+                if (ok)
+                    written++;
+                else
+                    reportFailure("write", outputs[job.index]);
+                job.img = Image{};
+            }
+        });
+
+    for (std::thread& thread : threads)
+        thread.join();
+    const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+
+    const double megapixels = pixels.load() * 1e-6;
+    std::printf("%zu of %zu images, %.1f MP in %.2f s (%.1f images/s, %.1f MP/s); "
+        "%d workers, %d decoder and %d encoder threads\n",
+        written.load(), inputs.size(), megapixels, wall,
+        written.load() / wall, megapixels / wall, workers, options.io, options.io);
+
+    const double images = static_cast<double>(std::max<size_t>(1, inputs.size() - failed.load()));
+    auto row = [&](const std::string& name, const Timer& timer)
+    {
+        std::printf("%-36s %10.3f %10.3f\n", name.c_str(), timer.seconds(), timer.seconds() * 1e3 / images);
+    };
+    std::printf("%-36s %10s %10s\n", "stage", "total s", "ms/image");
+    row("decode", decodeTime);
+    row("process", processTime);
+    for (size_t s = 0; s < steps.size(); s++)
+        row("  " + steps[s].label, stepTimes[s]);
+    row("encode", encodeTime);
+    row("workers waiting for input", idleTime);
+
+    return failed.load() == 0 ? 0 : 2;
+}
@@ -0,0 +1,507 @@
+// cvfp_bench: times every imgproc operation on synthetic images.
+//
+//   cvfp_bench [--filter name] [--sizes 640x480,1920x1080] [--channels 1,3]
+//              [--threads n] [--scaling] [--simd scalar|sse41|avx2]
+//              [--min-time seconds] [--json file|-] [--accuracy]
+//
+// For each op, size and channel count it reports the median ns per input
+// pixel, throughput in megapixels/s and the peak heap growth of a single
+// call (tracked through a counting global operator new, with the buffer
+// pool emptied first so pooled buffers count as fresh allocations).
+// --scaling repeats every case for 1, 2, 4 ... getNumThreads() threads;
+// --simd forces a lower instruction set to compare against the SIMD paths.
+// --json writes the results in a stable, diffable form for regression
+// tracking. --accuracy reports, instead of timings, how far the fixed-point
+// uint8 Gaussian lands from the same blur run in float, and the box cascade
+// from the exact kernel.
+
+#include "GaussianFilter.h"
+#include "IntegralImage.h"
+#include "LaplacianPyramid.h"
+#include "boxBlur.h"
+#include "bufferPool.h"
+#include "colorConvert.h"
+#include "cpuFeatures.h"
+#include "enhancements.h"
+#include "imgOps.h"
+#include "lazy.h"
+#include "parallel.h"
+#include "pointLut.h"
+#include "rotate.h"
+#include "scale.h"
+#include "similarity.h"
+#include "testUtils.h"
+#include "translate.h"
+#include "warp.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace imgproc;
+
+// ---------------------------------------------------------------------------
+// heap tracking
+
+namespace
+{
+    std::atomic<size_t> liveBytes{ 0 };
+    std::atomic<size_t> peakBytes{ 0 };
+
+    // every block carries its size (and the malloc'd pointer) just before
+    // the address handed out, so unsized deletes can be accounted for
+    struct BlockHeader
+    {
+        void* raw;
+        size_t bytes;
+    };
+
+    void* trackedAlloc(size_t bytes, size_t alignment)
+    {
+        alignment = std::max(alignment, alignof(BlockHeader));
+        void* raw = std::malloc(bytes + alignment + sizeof(BlockHeader));
+        if (!raw)
+            throw std::bad_alloc();
+
+        uintptr_t p = reinterpret_cast<uintptr_t>(raw) + sizeof(BlockHeader);
+        p = (p + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+        reinterpret_cast<BlockHeader*>(p)[-1] = { raw, bytes };
+
+        const size_t live = liveBytes.fetch_add(bytes) + bytes;
+        size_t peak = peakBytes.load();
+        while (live > peak && !peakBytes.compare_exchange_weak(peak, live)) {}
+
+        return reinterpret_cast<void*>(p);
+    }
+
+    void trackedFree(void* p)
+    {
+        if (!p)
+            return;
+        const BlockHeader header = static_cast<BlockHeader*>(p)[-1];
+        liveBytes.fetch_sub(header.bytes);
+        std::free(header.raw);
+    }
+}
+
+void* operator new(size_t bytes) { return trackedAlloc(bytes, alignof(std::max_align_t)); }
+void* operator new[](size_t bytes) { return trackedAlloc(bytes, alignof(std::max_align_t)); }
+void* operator new(size_t bytes, std::align_val_t a) { return trackedAlloc(bytes, static_cast<size_t>(a)); }
+void* operator new[](size_t bytes, std::align_val_t a) { return trackedAlloc(bytes, static_cast<size_t>(a)); }
+void operator delete(void* p) noexcept { trackedFree(p); }
+void operator delete[](void* p) noexcept { trackedFree(p); }
+void operator delete(void* p, size_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, size_t) noexcept { trackedFree(p); }
+void operator delete(void* p, std::align_val_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { trackedFree(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { trackedFree(p); }
+
+// ---------------------------------------------------------------------------
+// cases
+
+namespace
+{
+    struct Case
+    {
+        std::string name;
+        std::function<void(const Image&)> run;
+        bool colorOnly = false; // needs 3-channel BGR input
+        // for inputs that are not 8-bit: builds them from the test image
+        // outside the timing and returns what to time instead of run
+        std::function<std::function<void()>(const Image&)> prepare = nullptr;
+    };
+
+    std::vector<Case> allCases()
+    {
+        using Method = Rotation::rotateMethod;
+        using Scaling = Scale::InterpolationMethod;
+
+        std::vector<Case> cases = {
+            { "rotate_fwd_30", [](const Image& img) { Rotation::rotate(img, 30, Method::FWD_MAP); } },
+            { "rotate_inv_nn_30", [](const Image& img) { Rotation::rotate(img, 30, Method::INV_MAP); } },
+            { "rotate_inv_bilinear_30", [](const Image& img) { Rotation::rotate(img, 30, Method::INV_MAP, Interpolation::Bilinear); } },
+            { "rotate_inv_bicubic_30", [](const Image& img) { Rotation::rotate(img, 30, Method::INV_MAP, Interpolation::Bicubic); } },
+            { "scale_nn_x2", [](const Image& img) { Scale::scale(img, Scaling::NearestNeighbour, 2); } },
+            { "scale_bilinear_x2", [](const Image& img) { Scale::scale(img, Scaling::Bilinear, 2); } },
+            { "scale_bilinear_x0.5", [](const Image& img) { Scale::scale(img, Scaling::Bilinear, 0.5); } },
+            { "scale_area_x0.5", [](const Image& img) { Scale::scale(img, Scaling::Area, 0.5); } },
+            { "scale_area_x0.667", [](const Image& img) { Scale::scale(img, Scaling::Area, 2.0 / 3); } },
+            { "translate_50_-20", [](const Image& img) { translate(img, 50, -20); } },
+            { "similarity_2_45", [](const Image& img) { similarityTransform(img, 2, 45, 100, 100); } },
+            { "warp_affine_bilinear", [](const Image& img) {
+                warpAffine(img, AffineMatrix::rotation(10, img.cols / 2.0, img.rows / 2.0) * AffineMatrix::scaling(0.9, 0.9)); } },
+            { "gaussian_3", [](const Image& img) { applyGuassian(img, 3, 1.f); } },
+            { "gaussian_5", [](const Image& img) { applyGuassian(img, 5, 1.4f); } },
+            { "gaussian_7", [](const Image& img) { applyGuassian(img, 7, 2.f); } },
+            { "gaussian_5_u16", nullptr, false, [](const Image& img) -> std::function<void()> {
+                return [src = convertTo<uint16_t>(img, 257.f)] { applyGuassian(src, 5, 1.4f); }; } },
+            { "gaussian_5_f32", nullptr, false, [](const Image& img) -> std::function<void()> {
+                return [src = convertTo<float>(img, 1 / 255.f)] { applyGuassian(src, 5, 1.4f); }; } },
+            { "gaussian_sigma_20", [](const Image& img) { applyGuassian(img, 20.f); } },
+            { "box_blur_40", [](const Image& img) { boxBlurGaussian(img, 40.f); } },
+            { "gaussian_5_gray_fused", [](const Image& img) { applyGuassianGray(img, 5, 1.4f); }, true },
+            { "integral", [](const Image& img) { integral<uint32_t>(img.view()); } },
+            { "box_filter_7", [](const Image& img) { boxFilter(img, 7); } },
+            { "box_filter_50", [](const Image& img) { boxFilter(img, 50); } },
+            { "local_variance_7", [](const Image& img) { localVariance(img, 7); } },
+            { "pad_8", [](const Image& img) { padImage(img, 8); } },
+            { "pyramid", [](const Image& img) { getGuassianPyramid(img); } },
+            { "laplacian_pyramid", [](const Image& img) { getLaplacianPyramid(img); } },
+            { "laplacian_reconstruct", [](const Image& img) {
+                // includes the decomposition; subtract laplacian_pyramid for the collapse alone
+                reconstruct(getLaplacianPyramid(img)); } },
+            { "brightness", [](const Image& img) { adjustBrightness(img, 40); } },
+            { "contrast", [](const Image& img) { contrast(img, 1.5f); } },
+            { "invert", [](const Image& img) { invert(img); } },
+            { "gamma", [](const Image& img) { gamma(img, 0.8f); } },
+            { "lut_chain_5", [](const Image& img) {
+                PointLut().brightness(20).contrast(1.2f).invert().gamma(0.8f).brightness(-5).apply(img); } },
+            // the same chain run op by op and through LazyImage
+            { "chain_eager", [](const Image& img) {
+                applyGuassian(Rotation::rotate(Scale::scale(contrast(adjustBrightness(img, 20), 1.2f),
+                    Scaling::Bilinear, 1.5), 30, Method::INV_MAP, Interpolation::Bilinear), 5, 1.4f); } },
+            { "chain_lazy", [](const Image& img) {
+                LazyImage(img).brightness(20).contrast(1.2f).scale(1.5)
+                    .rotate(30, Interpolation::Bilinear).gaussian(5, 1.4f).eval(); } },
+            { "gray", [](const Image& img) { bgrToGray(img); }, true },
+            { "bgr_to_yuv", [](const Image& img) { bgrToYuv(img); }, true },
+            { "yuv_to_bgr", [](const Image& img) { yuvToBgr(img); }, true },
+            { "bgr_to_hsv", [](const Image& img) { bgrToHsv(img); }, true },
+            { "hsv_to_bgr", [](const Image& img) { hsvToBgr(img); }, true },
+        };
+        return cases;
+    }
+
+    // smooth gradients plus noise, so no op sees a degenerate flat image
+    Image syntheticImage(int rows, int cols, int channels)
+    {
+        Image img(rows, cols, channels, ImageInit::Uninitialized);
+        test::Lcg lcg{ 12345 };
+        for (int y = 0; y < rows; y++)
+        {
+            uint8_t* p = img.row(y);
+            for (int x = 0; x < cols; x++)
+                for (int c = 0; c < channels; c++)
+                {
+                    const int v = (x * 255 / std::max(1, cols - 1) + y * 255 / std::max(1, rows - 1)) / 2
+                        + 40 * c + static_cast<int>(lcg.next() >> 28) - 8;
+                    *p++ = static_cast<uint8_t>(std::clamp(v, 0, 255));
+                }
+        }
+        return img;
+    }
+
+    struct Result
+    {
+        std::string op;
+        int rows, cols, channels, threads;
+        const char* simd;
+        int iterations;
+        double nsPerPixel;  // median
+        double bestNsPerPixel;
+        double mpixPerSec;  // from the median
+        size_t peakBytes;
+    };
+
+    struct Options
+    {
+        std::string filter;
+        std::vector<std::pair<int, int>> sizes{ { 480, 640 }, { 1080, 1920 }, { 2160, 3840 } };
+        std::vector<int> channels{ 1, 3 };
+        int threads = 0;
+        bool scaling = false;
+        SimdLevel simd = detectedSimdLevel();
+        double minTime = 0.25;
+        std::string json;
+        bool accuracy = false;
+    };
+
+    const char* simdName(SimdLevel level)
+    {
+        switch (level)
+        {
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::SSE41: return "sse41";
+        default: return "scalar";
+        }
+    }
+
+    Result measure(const Case& c, const Image& img, int threads, double minTime)
+    {
+        using clock = std::chrono::steady_clock;
+
+        const std::function<void()> call = c.prepare ? c.prepare(img)
+                                                     : std::function<void()>([&] { c.run(img); });
+
+        // peak of one call, with nothing parked in the pool
+        trimBufferPool();
+        const size_t baseline = liveBytes.load();
+        peakBytes.store(baseline);
+        call();
+        const size_t peak = peakBytes.load() - baseline;
+
+        // then time until minTime has passed (at least 3 runs)
+        std::vector<double> seconds;
+        const auto start = clock::now();
+        do
+        {
+            const auto t0 = clock::now();
+            call();
+            seconds.push_back(std::chrono::duration<double>(clock::now() - t0).count());
+        } while (seconds.size() < 3 || std::chrono::duration<double>(clock::now() - start).count() < minTime);
+
+        std::sort(seconds.begin(), seconds.end());
+        const double pixels = static_cast<double>(img.rows) * img.cols;
+        const double median = seconds[seconds.size() / 2];
+
+        return { c.name, img.rows, img.cols, img.channels, threads, simdName(simdLevel()),
+            static_cast<int>(seconds.size()), median * 1e9 / pixels, seconds.front() * 1e9 / pixels,
+            pixels / median / 1e6, peak };
+    }
+
+    struct Accuracy
+    {
+        std::string op;
+        int rows, cols, channels;
+        double maxError;    // largest |uint8 - float| in grey levels
+        double meanError;
+        double exact;       // fraction equal to the float result rounded
+    };
+
+    Accuracy compare(const std::string& op, const Image& approx, const ImageF& reference)
+    {
+        double maxError = 0, sumError = 0;
+        size_t exact = 0;
+        const int rowElems = approx.cols * approx.channels;
+        for (int y = 0; y < approx.rows; y++)
+            for (int i = 0; i < rowElems; i++)
+            {
+                const double error = std::abs(approx.row(y)[i] - static_cast<double>(reference.row(y)[i]));
+                maxError = std::max(maxError, error);
+                sumError += error;
+                exact += approx.row(y)[i] == saturateCast<uint8_t>(reference.row(y)[i]);
+            }
+
+        const double n = static_cast<double>(approx.rows) * rowElems;
+        return { op, approx.rows, approx.cols, approx.channels, maxError, sumError / n, exact / n };
+    }
+
+    // the uint8 blur (fixed point) against the float blur of the same
+    // pixels, and the box cascade against the exact kernel in float
+    std::vector<Accuracy> gaussianAccuracy(const Image& img)
+    {
+        const std::pair<uint8_t, float> kernels[] = { { 3, 1.f }, { 5, 1.4f }, { 7, 2.f }, { 15, 4.f } };
+        const ImageF imgF = convertTo<float>(img);
+
+        std::vector<Accuracy> report;
+        for (const auto& [size, sigma] : kernels)
+            report.push_back(compare("gaussian_" + std::to_string(size),
+                applyGuassian(img, size, sigma), applyGuassian(imgF, size, sigma)));
+
+        for (const float sigma : { 10.f, 20.f, 40.f })
+        {
+            report.push_back(compare("box_blur_" + std::to_string(static_cast<int>(sigma)),
+                boxBlurGaussian(img, sigma), applyGuassian(imgF, gaussianKernelSize(sigma), sigma)));
+        }
+        return report;
+    }
+
+    void writeJson(FILE* out, const std::vector<Accuracy>& report)
+    {
+        std::fprintf(out, "{\n  \"accuracy\": [\n");
+        for (size_t i = 0; i < report.size(); i++)
+        {
+            const Accuracy& a = report[i];
+            std::fprintf(out,
+                "    {\"op\": \"%s\", \"rows\": %d, \"cols\": %d, \"channels\": %d, "
+                "\"max_error\": %.4f, \"mean_error\": %.4f, \"exact\": %.4f}%s\n",
+                a.op.c_str(), a.rows, a.cols, a.channels, a.maxError, a.meanError, a.exact,
+                i + 1 < report.size() ? "," : "");
+        }
+        std::fprintf(out, "  ]\n}\n");
+    }
+
+    void writeJson(FILE* out, const std::vector<Result>& results)
+    {
+        std::fprintf(out, "{\n  \"detected_simd\": \"%s\",\n  \"results\": [\n", simdName(detectedSimdLevel()));
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result& r = results[i];
+            std::fprintf(out,
+                "    {\"op\": \"%s\", \"rows\": %d, \"cols\": %d, \"channels\": %d, \"threads\": %d, "
+                "\"simd\": \"%s\", \"iterations\": %d, \"ns_per_pixel\": %.4f, \"best_ns_per_pixel\": %.4f, "
+                "\"mpix_per_s\": %.2f, \"peak_bytes\": %zu}%s\n",
+                r.op.c_str(), r.rows, r.cols, r.channels, r.threads, r.simd, r.iterations,
+                r.nsPerPixel, r.bestNsPerPixel, r.mpixPerSec, r.peakBytes,
+                i + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(out, "  ]\n}\n");
+    }
+
+    bool parseArgs(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--filter" && hasValue)
+                options.filter = argv[++i];
+            else if (arg == "--sizes" && hasValue)
+            {
+                options.sizes.clear();
+                for (const char* s = argv[++i]; *s;)
+                {
+                    int w = 0, h = 0, used = 0;
+                    if (std::sscanf(s, "%dx%d%n", &w, &h, &used) != 2 || w <= 0 || h <= 0)
+                        return false;
+                    options.sizes.emplace_back(h, w);
+                    s += used;
+                    if (*s == ',')
+                        s++;
+                }
+            }
+            else if (arg == "--channels" && hasValue)
+            {
+                options.channels.clear();
+                for (const char* s = argv[++i]; *s;)
+                {
+                    char* end;
+                    const long c = std::strtol(s, &end, 10);
+                    if (end == s || c <= 0)
+                        return false;
+                    options.channels.push_back(static_cast<int>(c));
+                    s = *end == ',' ? end + 1 : end;
+                }
+            }
+            else if (arg == "--threads" && hasValue)
+                options.threads = std::atoi(argv[++i]);
+            else if (arg == "--scaling")
+                options.scaling = true;
+            else if (arg == "--simd" && hasValue)
+            {
+                const std::string level = argv[++i];
+                if (level == "scalar")
+                    options.simd = SimdLevel::Scalar;
+                else if (level == "sse41")
+                    options.simd = SimdLevel::SSE41;
+                else if (level == "avx2")
+                    options.simd = SimdLevel::AVX2;
+                else
+                    return false;
+            }
+            else if (arg == "--min-time" && hasValue)
+                options.minTime = std::atof(argv[++i]);
+            else if (arg == "--json" && hasValue)
+                options.json = argv[++i];
+            else if (arg == "--accuracy")
+                options.accuracy = true;
+            else
+                return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseArgs(argc, argv, options))
+    {
+        std::fprintf(stderr, "usage: %s [--filter name] [--sizes WxH,...] [--channels 1,3] "
+            "[--threads n] [--scaling] [--simd scalar|sse41|avx2] [--min-time s] [--json file|-] [--accuracy]\n", argv[0]);
+        return 1;
+    }
+
+    setNumThreads(options.threads);
+    setSimdLevel(options.simd);
+
+    std::vector<int> threadCounts{ getNumThreads() };
+    if (options.scaling)
+    {
+        threadCounts.clear();
+        for (int t = 1; t < getNumThreads(); t *= 2)
+            threadCounts.push_back(t);
+        threadCounts.push_back(getNumThreads());
+    }
+    const int maxThreads = getNumThreads();
+
+    // the table goes to stderr when the JSON goes to stdout
+    FILE* table = options.json == "-" ? stderr : stdout;
+
+    std::vector<Accuracy> report;
+    std::vector<Result> results;
+    if (options.accuracy)
+    {
+        std::fprintf(table, "%-26s %11s %3s %10s %10s %10s\n",
+            "op", "size", "ch", "max err", "mean err", "exact %");
+        for (const auto& [rows, cols] : options.sizes)
+            for (int channels : options.channels)
+                for (const Accuracy& a : gaussianAccuracy(syntheticImage(rows, cols, channels)))
+                {
+                    const std::string size = std::to_string(cols) + "x" + std::to_string(rows);
+                    std::fprintf(table, "%-26s %11s %3d %10.3f %10.4f %10.2f\n",
+                        a.op.c_str(), size.c_str(), a.channels, a.maxError, a.meanError, a.exact * 100);
+                    report.push_back(a);
+                }
+    }
+    else
+    {
+        std::fprintf(table, "%-26s %11s %3s %4s %7s %10s %10s %10s\n",
+            "op", "size", "ch", "thr", "simd", "ns/px", "MP/s", "peak MB");
+
+        for (const Case& c : allCases())
+        {
+            if (!options.filter.empty() && c.name.find(options.filter) == std::string::npos)
+                continue;
+
+            for (const auto& [rows, cols] : options.sizes)
+                for (int channels : options.channels)
+                {
+                    if (c.colorOnly && channels != 3)
+                        continue;
+
+                    const Image img = syntheticImage(rows, cols, channels);
+                    for (int threads : threadCounts)
+                    {
+                        setNumThreads(threads);
+                        const Result r = measure(c, img, threads, options.minTime);
+                        results.push_back(r);
+
+                        const std::string size = std::to_string(cols) + "x" + std::to_string(rows);
+                        std::fprintf(table, "%-26s %11s %3d %4d %7s %10.3f %10.1f %10.2f\n",
+                            r.op.c_str(), size.c_str(), r.channels, r.threads, r.simd,
+                            r.nsPerPixel, r.mpixPerSec, r.peakBytes / (1024.0 * 1024.0));
+                    }
+                    setNumThreads(maxThreads);
+                }
+        }
+    }
+
+    if (!options.json.empty())
+    {
+        FILE* out = options.json == "-" ? stdout : std::fopen(options.json.c_str(), "w");
+        if (!out)
+        {
+            std::fprintf(stderr, "cannot write %s\n", options.json.c_str());
+            return 1;
+        }
+        if (options.accuracy)
+            writeJson(out, report);
+        else
+            writeJson(out, results);
+        if (out != stdout)
+            std::fclose(out);
+    }
+
+    return 0;
+}
@@ -0,0 +1,253 @@
+// Gaussian blur approximated by a cascade of box filters
+
+#include "boxBlur.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+    using namespace imgproc;
+
+    // a box of radius r with an extra tap of weight alpha at either end;
+    // alpha in [0, 1) makes up the variance a whole tap would overshoot
+    // (Gwosdek et al., "Theoretical foundations of Gaussian convolution by
+    // extended box filtering")
+    struct ExtendedBox
+    {
+        int radius;
+        float alpha;
+        float scale; // 1 / (2r + 1 + 2 alpha)
+    };
+
+    ExtendedBox extendedBox(float stdDev, int passes)
+    {
+        const double variance = static_cast<double>(stdDev) * stdDev / passes;
+
+        // widest plain box whose variance r(r + 1) / 3 does not exceed it
+        const int r = static_cast<int>((std::sqrt(12 * variance + 1) - 1) / 2);
+        const double alpha = (2 * r + 1) * (variance - r * (r + 1) / 3.0)
+            / (2 * ((r + 1.0) * (r + 1.0) - variance));
+
+        return { r, static_cast<float>(alpha), static_cast<float>(1 / (2 * r + 1 + 2 * alpha)) };
+    }
+
+    /*
+        a line of `len` positions with `lanes` interleaved values each (a
+        block of rows transposed, or a strip of columns), stored after `pad`
+        zero positions and followed by as many. pad = passes * (r + 1), so
+        every pass can read r + 1 positions past where the previous one
+        wrote and the data still sees the black border it would in an
+        infinite zero-padded line:
+
+        | r+1 kept zero | pad - r - 1 | data | pad - r - 1 | r+1 kept zero |
+
+        `spare` is scratch of the same size; returns whichever of the two
+        holds the result after the last pass. lanes are independent running
+        sums, so a compile-time L keeps them in registers and vectorizes.
+    */
+    template <int L>
+    float* boxLine(float* line, float* spare, int len, int lanes,
+        int pad, const ExtendedBox& box, int passes)
+    {
+        if constexpr (L != 0)
+            lanes = L;
+
+        std::conditional_t<L != 0, std::array<float, L>, std::vector<float>> sums{};
+        if constexpr (L == 0)
+            sums.resize(lanes);
+
+        const int r = box.radius;
+        const int end = len + 2 * pad - r - 1;
+
+        float* in = line;
+        float* out = spare;
+        std::fill(out, out + static_cast<size_t>(r + 1) * lanes, 0.f);
+        std::fill(out + static_cast<size_t>(end) * lanes, out + static_cast<size_t>(end + r + 1) * lanes, 0.f);
+        for (int p = 0; p < passes; p++)
+        {
+            // sums hold in[x - r .. x + r] for the first x written
+            std::fill(sums.begin(), sums.end(), 0.f);
+            for (int i = 1; i <= 2 * r + 1; i++)
+                for (int l = 0; l < lanes; l++)
+                    sums[l] += in[i * lanes + l];
+
+            for (int x = r + 1; x < end; x++)
+            {
+                const float* before = in + static_cast<size_t>(x - r - 1) * lanes;
+                const float* first = before + lanes;
+                const float* after = in + static_cast<size_t>(x + r + 1) * lanes;
+                float* o = out + static_cast<size_t>(x) * lanes;
+                for (int l = 0; l < lanes; l++)
+                {
+                    o[l] = (sums[l] + box.alpha * (before[l] + after[l])) * box.scale;
+                    sums[l] += after[l] - first[l];
+                }
+            }
+            std::swap(in, out);
+        }
+        return in;
+    }
+
+    // rows per horizontal block and elements per vertical strip: enough
+    // lanes to fill vector registers, few enough that a line stays in cache
+    constexpr int blockRows = 8;
+    constexpr int stripElems = 64;
+
+    template <typename T>
+    void boxBlurT(ImageViewT<const T> src, ImageViewT<T> dst, float stdDev, int passes)
+    {
+        /*
+            both directions run the same boxLine over many lines at once.
+            rows: a block of blockRows rows is transposed into one line whose
+            lanes are (row, channel), filtered, and written to a float image.
+            columns: a strip of stripElems columns of that image is copied
+            position-major and filtered with the columns as lanes. short
+            blocks and strips are padded with zero lanes.
+            all of src is read before any of dst is written, so the two may
+            be the same view.
+        */
+
+        if (src.empty())
+            return;
+
+        passes = std::max(1, passes);
+        const ExtendedBox box = extendedBox(std::max(stdDev, 0.f), passes);
+        const int r = box.radius;
+        const int pad = passes * (r + 1);
+        const int channels = src.channels;
+        const int rowElems = src.rowElems();
+
+        std::vector<float> rowsPass(static_cast<size_t>(src.rows) * rowElems);
+
+        withChannels(channels, [&](auto c)
+        {
+            constexpr int C = decltype(c)::value;
+            constexpr int L = C * blockRows;
+            const int lanes = channels * blockRows;
+
+            parallelFor(0, (src.rows + blockRows - 1) / blockRows, [&](int bBegin, int bEnd)
+            {
+                const size_t size = static_cast<size_t>(src.cols + 2 * pad) * lanes;
+                std::vector<float> line(size), spare(size);
+                float* data = line.data() + static_cast<size_t>(pad) * lanes;
+
+                for (int b = bBegin; b < bEnd; b++)
+                {
+                    const int y0 = b * blockRows;
+                    const int rows = std::min(blockRows, src.rows - y0);
+
+                    // the previous block's passes left values in the padding
+                    std::fill(line.data(), data, 0.f);
+                    std::fill(data + static_cast<size_t>(src.cols) * lanes, line.data() + size, 0.f);
+                    if (rows < blockRows)
+                        std::fill(data, data + static_cast<size_t>(src.cols) * lanes, 0.f);
+
+                    for (int j = 0; j < rows; j++)
+                    {
+                        const T* in = src.row(y0 + j);
+                        float* d = data + j * channels;
+                        for (int x = 0; x < src.cols; x++)
+                            for (int k = 0; k < channels; k++)
+                                d[static_cast<size_t>(x) * lanes + k] = static_cast<float>(in[x * channels + k]);
+                    }
+
+                    const float* result = boxLine<L>(line.data(), spare.data(), src.cols, lanes, pad, box, passes)
+                        + static_cast<size_t>(pad) * lanes;
+                    for (int j = 0; j < rows; j++)
+                    {
+                        float* out = rowsPass.data() + static_cast<size_t>(y0 + j) * rowElems;
+                        const float* d = result + j * channels;
+                        for (int x = 0; x < src.cols; x++)
+                            for (int k = 0; k < channels; k++)
+                                out[x * channels + k] = d[static_cast<size_t>(x) * lanes + k];
+                    }
+                }
+            });
+        });
+
+        parallelFor(0, (rowElems + stripElems - 1) / stripElems, [&](int sBegin, int sEnd)
+        {
+            const size_t size = static_cast<size_t>(src.rows + 2 * pad) * stripElems;
+            std::vector<float> line(size), spare(size);
+            float* data = line.data() + static_cast<size_t>(pad) * stripElems;
+
+            for (int s = sBegin; s < sEnd; s++)
+            {
+                const int x0 = s * stripElems;
+                const int elems = std::min(stripElems, rowElems - x0);
+
+                std::fill(line.data(), data, 0.f);
+                std::fill(data + static_cast<size_t>(src.rows) * stripElems, line.data() + size, 0.f);
+                for (int y = 0; y < src.rows; y++)
+                {
+                    float* d = data + static_cast<size_t>(y) * stripElems;
+                    std::memcpy(d, rowsPass.data() + static_cast<size_t>(y) * rowElems + x0, elems * sizeof(float));
+                    std::fill(d + elems, d + stripElems, 0.f);
+                }
+
+                const float* result = boxLine<stripElems>(line.data(), spare.data(), src.rows,
+                    stripElems, pad, box, passes) + static_cast<size_t>(pad) * stripElems;
+                for (int y = 0; y < src.rows; y++)
+                {
+                    T* out = dst.row(y) + x0;
+                    const float* d = result + static_cast<size_t>(y) * stripElems;
+                    for (int i = 0; i < elems; i++)
+                        out[i] = saturateCast<T>(d[i]);
+                }
+            }
+        });
+    }
+
+    template <typename T>
+    ImageT<T> boxBlurred(const ImageT<T>& img, float stdDev, int passes)
+    {
+        if (img.empty())
+            return ImageT<T>{};
+
+        ImageT<T> out(img.rows, img.cols, img.channels, ImageInit::Uninitialized);
+        boxBlurT<T>(img.view(), out.view(), stdDev, passes);
+        return out;
+    }
+}
+
+void imgproc::boxBlurGaussian(ConstImageView src, ImageView dst,
+    const float stdDev, const int passes)
+{
+    boxBlurT<uint8_t>(src, dst, stdDev, passes);
+}
+
+void imgproc::boxBlurGaussian(ConstImageView16 src, ImageView16 dst,
+    const float stdDev, const int passes)
+{
+    boxBlurT<uint16_t>(src, dst, stdDev, passes);
+}
+
+void imgproc::boxBlurGaussian(ConstImageViewF src, ImageViewF dst,
+    const float stdDev, const int passes)
+{
+    boxBlurT<float>(src, dst, stdDev, passes);
+}
+
+imgproc::Image imgproc::boxBlurGaussian(const Image& img,
+    const float stdDev, const int passes)
+{
+    return boxBlurred(img, stdDev, passes);
+}
+
+imgproc::Image16 imgproc::boxBlurGaussian(const Image16& img,
+    const float stdDev, const int passes)
+{
+    return boxBlurred(img, stdDev, passes);
+}
+
+imgproc::ImageF imgproc::boxBlurGaussian(const ImageF& img,
+    const float stdDev, const int passes)
+{
+    return boxBlurred(img, stdDev, passes);
+}
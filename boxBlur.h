@@ -0,0 +1,36 @@
+#pragma once
+
+#include "imgOps.h"
+
+namespace imgproc
+{
+    // Gaussian blur of standard deviation stdDev approximated by `passes`
+    // box filters along rows, then along columns. Each pass is a running
+    // sum, so the cost per pixel does not depend on sigma. The boxes are
+    // "extended" (a fractional tap at either end) so the variance of the
+    // cascade is exactly stdDev^2, and borders read as black like
+    // applyGuassian.
+    //
+    // Error against the exact Gaussian: the 1-D cascade kernel B differs
+    // from the sampled Gaussian G by ||B - G||_1 ~ 0.05 for 3 passes
+    // (0.04 for 4, 0.03 for 5), nearly independent of sigma, so no output
+    // can be further than 2 * ||B - G||_1 * 255 ~ 26 grey levels (3 passes)
+    // from the exact blur. That bound needs an image built to match the
+    // kernel's ripple; on cvfp_bench's images (--accuracy) the largest error
+    // is about 4.5 grey levels, next to the black border, and the mean 0.3.
+    //
+    // dst is src's size and may be src itself.
+    void boxBlurGaussian(ConstImageView src, ImageView dst,
+        const float stdDev, const int passes = 3);
+    void boxBlurGaussian(ConstImageView16 src, ImageView16 dst,
+        const float stdDev, const int passes = 3);
+    void boxBlurGaussian(ConstImageViewF src, ImageViewF dst,
+        const float stdDev, const int passes = 3);
+
+    Image boxBlurGaussian(const Image& img, const float stdDev,
+        const int passes = 3);
+    Image16 boxBlurGaussian(const Image16& img, const float stdDev,
+        const int passes = 3);
+    ImageF boxBlurGaussian(const ImageF& img, const float stdDev,
+        const int passes = 3);
+}
@@ -0,0 +1,149 @@
+#include "bufferPool.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+    // cache-line aligned so SIMD loads never straddle the buffer start
+    constexpr std::align_val_t bufferAlignment{ 64 };
+
+    class BufferPool
+    {
+    public:
+        void* allocate(size_t bytes)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = parked.find(bytes);
+                if (it != parked.end() && !it->second.empty())
+                {
+                    void* p = it->second.back();
+                    it->second.pop_back();
+                    cachedBytes -= bytes;
+                    reuses.fetch_add(1, std::memory_order_relaxed);
+                    return p;
+                }
+            }
+
+            allocations.fetch_add(1, std::memory_order_relaxed);
+            bytesAllocated.fetch_add(bytes, std::memory_order_relaxed);
+            return ::operator new(bytes, bufferAlignment);
+        }
+
+        void deallocate(void* p, size_t bytes)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (cachedBytes + bytes <= limit)
+                {
+                    parked[bytes].push_back(p);
+                    cachedBytes += bytes;
+                    return;
+                }
+            }
+            ::operator delete(p, bufferAlignment);
+        }
+
+        void trim()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto& [bytes, buffers] : parked)
+                for (void* p : buffers)
+                    ::operator delete(p, bufferAlignment);
+            parked.clear();
+            cachedBytes = 0;
+        }
+
+        void setLimit(size_t bytes)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                limit = bytes;
+                if (cachedBytes <= limit)
+                    return;
+            }
+            trim();
+        }
+
+        imgproc::BufferPoolStats stats()
+        {
+            imgproc::BufferPoolStats s;
+            s.allocations = allocations.load(std::memory_order_relaxed);
+            s.reuses = reuses.load(std::memory_order_relaxed);
+            s.bytesAllocated = bytesAllocated.load(std::memory_order_relaxed);
+            s.bytesZeroed = bytesZeroed.load(std::memory_order_relaxed);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            s.bytesCached = cachedBytes;
+            return s;
+        }
+
+        void resetStats()
+        {
+            allocations = 0;
+            reuses = 0;
+            bytesAllocated = 0;
+            bytesZeroed = 0;
+        }
+
+        void addZeroed(size_t bytes)
+        {
+            bytesZeroed.fetch_add(bytes, std::memory_order_relaxed);
+        }
+
+    private:
+        std::mutex mutex;
+        std::unordered_map<size_t, std::vector<void*>> parked;
+        size_t cachedBytes = 0;
+        size_t limit = size_t(512) << 20;
+
+        std::atomic<size_t> allocations{ 0 };
+        std::atomic<size_t> reuses{ 0 };
+        std::atomic<size_t> bytesAllocated{ 0 };
+        std::atomic<size_t> bytesZeroed{ 0 };
+    };
+
+    // never destroyed: Images with static storage may release into it at exit
+    BufferPool& pool()
+    {
+        static BufferPool* instance = new BufferPool;
+        return *instance;
+    }
+}
+
+imgproc::BufferPoolStats imgproc::bufferPoolStats()
+{
+    return pool().stats();
+}
+
+void imgproc::resetBufferPoolStats()
+{
+    pool().resetStats();
+}
+
+void imgproc::setBufferPoolLimit(size_t bytes)
+{
+    pool().setLimit(bytes);
+}
+
+void imgproc::trimBufferPool()
+{
+    pool().trim();
+}
+
+void* imgproc::detail::poolAllocate(size_t bytes)
+{
+    return pool().allocate(bytes);
+}
+
+void imgproc::detail::poolDeallocate(void* p, size_t bytes)
+{
+    pool().deallocate(p, bytes);
+}
+
+void imgproc::detail::countZeroed(size_t bytes)
+{
+    pool().addZeroed(bytes);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Recycles pixel buffers between frames.
+// Every Image buffer is allocated through PoolAllocator, so when an Image dies
+// its storage is parked in the pool (keyed by exact byte size) and handed to
+// the next Image of the same size instead of going back to the system.
+
+namespace imgproc
+{
+    struct BufferPoolStats
+    {
+        size_t allocations = 0;     // buffers obtained from the system allocator
+        size_t reuses = 0;          // buffers served from the pool
+        size_t bytesAllocated = 0;  // bytes obtained from the system allocator
+        size_t bytesZeroed = 0;     // bytes cleared to black by Images and borders
+        size_t bytesCached = 0;     // bytes parked in the pool right now
+    };
+
+    // counters since the last reset (bytesCached is always current)
+    BufferPoolStats bufferPoolStats();
+    void resetBufferPoolStats();
+
+    // upper bound on parked bytes; buffers released beyond it are freed
+    void setBufferPoolLimit(size_t bytes);
+
+    // free every parked buffer
+    void trimBufferPool();
+
+    namespace detail
+    {
+        void* poolAllocate(size_t bytes);
+        void poolDeallocate(void* p, size_t bytes);
+        void countZeroed(size_t bytes);
+    }
+
+    template <typename T>
+    struct PoolAllocator
+    {
+        using value_type = T;
+
+        PoolAllocator() = default;
+        template <typename U>
+        PoolAllocator(const PoolAllocator<U>&) {}
+
+        T* allocate(size_t n) { return static_cast<T*>(detail::poolAllocate(n * sizeof(T))); }
+        void deallocate(T* p, size_t n) { detail::poolDeallocate(p, n * sizeof(T)); }
+
+        // default-initialise, so resize(n) leaves pixels uninitialised;
+        // resize(n, value) still fills
+        template <typename U>
+        void construct(U* p) { ::new (static_cast<void*>(p)) U; }
+        template <typename U, typename... Args>
+        void construct(U* p, Args&&... args) { ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...); }
+
+        template <typename U>
+        bool operator==(const PoolAllocator<U>&) const { return true; }
+        template <typename U>
+        bool operator!=(const PoolAllocator<U>&) const { return false; }
+    };
+
+    template <typename T>
+    using PixelBufferT = std::vector<T, PoolAllocator<T>>;
+    using PixelBuffer = PixelBufferT<uint8_t>;
+}
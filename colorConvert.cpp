@@ -0,0 +1,351 @@
+#include "colorConvert.h"
+#include "colorConvert_simd.h"
+#include "cpuFeatures.h"
+#include "imgOps.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+using namespace imgproc;
+using imgproc::detail::ColorMatrix;
+
+namespace
+{
+    constexpr int16_t fixedPoint(double c, int shift)
+    {
+        return static_cast<int16_t>(c * (1 << shift) + (c < 0 ? -0.5 : 0.5));
+    }
+
+    // input order is B, G, R
+    constexpr ColorMatrix grayMatrix()
+    {
+        ColorMatrix m{};
+        m.shift = 14;
+        m.outChannels = 1;
+        m.coeff[0][0] = fixedPoint(0.114, m.shift);
+        m.coeff[0][1] = fixedPoint(0.587, m.shift);
+        m.coeff[0][2] = fixedPoint(0.299, m.shift);
+        m.offset[0] = 1 << (m.shift - 1);
+        return m;
+    }
+
+    // Y = 0.299 R + 0.587 G + 0.114 B
+    // U = 0.492 (B - Y) + 128
+    // V = 0.877 (R - Y) + 128
+    constexpr ColorMatrix yuvMatrix()
+    {
+        ColorMatrix m{};
+        m.shift = 14;
+        m.outChannels = 3;
+        const double y[3] = { 0.114, 0.587, 0.299 };
+        for (int k = 0; k < 3; k++)
+        {
+            m.coeff[0][k] = fixedPoint(y[k], m.shift);
+            m.coeff[1][k] = fixedPoint(0.492 * ((k == 0) - y[k]), m.shift);
+            m.coeff[2][k] = fixedPoint(0.877 * ((k == 2) - y[k]), m.shift);
+        }
+        m.offset[0] = 1 << (m.shift - 1);
+        m.offset[1] = (128 << m.shift) + (1 << (m.shift - 1));
+        m.offset[2] = (128 << m.shift) + (1 << (m.shift - 1));
+        return m;
+    }
+
+    // B = Y + 2.032 (U - 128)
+    // G = Y - 0.395 (U - 128) - 0.581 (V - 128)
+    // R = Y + 1.140 (V - 128)
+    // 13 fractional bits: 2.032 does not fit int16 at 14
+    constexpr ColorMatrix bgrFromYuvMatrix()
+    {
+        ColorMatrix m{};
+        m.shift = 13;
+        m.outChannels = 3;
+        const double uv[3][2] = { { 2.032, 0.0 }, { -0.395, -0.581 }, { 0.0, 1.140 } };
+        for (int c = 0; c < 3; c++)
+        {
+            m.coeff[c][0] = fixedPoint(1.0, m.shift);
+            m.coeff[c][1] = fixedPoint(uv[c][0], m.shift);
+            m.coeff[c][2] = fixedPoint(uv[c][1], m.shift);
+            // fold the -128 on U and V into the offset
+            m.offset[c] = -128 * (m.coeff[c][1] + m.coeff[c][2]) + (1 << (m.shift - 1));
+        }
+        return m;
+    }
+
+    constexpr ColorMatrix toGray = grayMatrix();
+    constexpr ColorMatrix toYuv = yuvMatrix();
+    constexpr ColorMatrix fromYuv = bgrFromYuvMatrix();
+
+    // the view overloads leave dst untouched unless the sizes agree and
+    // the channel counts are the ones the conversion takes
+    bool shapesMatch(ConstImageView src, ImageView dst, int srcChannels, int dstChannels)
+    {
+        return !src.empty() && src.rows == dst.rows && src.cols == dst.cols
+            && src.channels == srcChannels && dst.channels == dstChannels;
+    }
+
+    // src and dst views must match in size; channel counts are checked by callers
+    void convertRows(ConstImageView src, ImageView dst, const ColorMatrix& m)
+    {
+        const detail::ColorMatrixRowFn rowFn = detail::selectColorMatrixRow();
+        parallelFor(0, src.rows, [&](int yBegin, int yEnd)
+        {
+            for (int y = yBegin; y < yEnd; y++)
+                rowFn(src.row(y), dst.row(y), src.cols, m);
+        }, 16);
+    }
+
+    // BGRA: the same fixed-point sum as BGR, alpha skipped, so both give
+    // identical gray. scalar; the matrix kernels step 3 bytes per pixel
+    void bgraToGrayRow(const uint8_t* src, uint8_t* dst, int n)
+    {
+        const int16_t* c = toGray.coeff[0];
+        for (int i = 0; i < n; i++, src += 4)
+        {
+            const int32_t acc = c[0] * src[0] + c[1] * src[1] + c[2] * src[2] + toGray.offset[0];
+            dst[i] = static_cast<uint8_t>(std::clamp(acc >> toGray.shift, 0, 255));
+        }
+    }
+
+    // fixed-point reciprocals for HSV, as in OpenCV: sdiv[v] = 255 / v,
+    // hdiv[d] = 30 / d (60 degrees per sector, halved to fit a byte)
+    constexpr int hsvShift = 12;
+
+    struct HsvTables
+    {
+        std::array<int, 256> sdiv{};
+        std::array<int, 256> hdiv{};
+
+        HsvTables()
+        {
+            for (int i = 1; i < 256; i++)
+            {
+                sdiv[i] = static_cast<int>(std::lround((255 << hsvShift) / static_cast<double>(i)));
+                hdiv[i] = static_cast<int>(std::lround((30 << hsvShift) / static_cast<double>(i)));
+            }
+        }
+    };
+
+    const HsvTables& hsvTables()
+    {
+        static const HsvTables tables;
+        return tables;
+    }
+
+    Image convertImage(const Image& img, void (*convert)(ConstImageView, ImageView), int outChannels)
+    {
+        if (img.empty() || img.channels != 3)
+            return Image{};
+
+        Image out(img.rows, img.cols, outChannels, ImageInit::Uninitialized);
+        convert(img.view(), out.view());
+        return out;
+    }
+}
+
+void imgproc::detail::colorMatrixRowScalar(const uint8_t* src, uint8_t* dst, int n,
+    const ColorMatrix& m)
+{
+    for (int i = 0; i < n; i++, src += 3)
+    {
+        for (int c = 0; c < m.outChannels; c++)
+        {
+            const int32_t acc = m.coeff[c][0] * src[0] + m.coeff[c][1] * src[1] +
+                m.coeff[c][2] * src[2] + m.offset[c];
+            dst[c] = static_cast<uint8_t>(std::clamp(acc >> m.shift, 0, 255));
+        }
+        dst += m.outChannels;
+    }
+}
+
+imgproc::detail::ColorMatrixRowFn imgproc::detail::selectColorMatrixRow()
+{
+    [[maybe_unused]] const SimdLevel level = simdLevel();
+#ifdef IMGPROC_HAVE_AVX2
+    if (level >= SimdLevel::AVX2)
+        return colorMatrixRowAVX2;
+#endif
+#ifdef IMGPROC_HAVE_SSE41
+    if (level >= SimdLevel::SSE41)
+        return colorMatrixRowSSE41;
+#endif
+    return colorMatrixRowScalar;
+}
+
+void imgproc::detail::bgrToGrayRow(const uint8_t* src, uint8_t* dst, int n)
+{
+    selectColorMatrixRow()(src, dst, n, toGray);
+}
+
+Image imgproc::bgrToGray(const Image& img)
+{
+    if (img.empty())
+        return Image{};
+
+    // already gray
+    if (img.channels == 1)
+        return img;
+    if (img.channels != 3 && img.channels != 4)
+        return Image{};
+
+    Image gray(img.rows, img.cols, 1, ImageInit::Uninitialized);
+    bgrToGray(img.view(), gray.view());
+    return gray;
+}
+
+void imgproc::bgrToGray(ConstImageView src, ImageView dst)
+{
+    if (!shapesMatch(src, dst, src.channels, 1))
+        return;
+
+    if (src.channels == 1)
+    {
+        parallelFor(0, src.rows, [&](int yBegin, int yEnd)
+        {
+            for (int y = yBegin; y < yEnd; y++)
+                std::memcpy(dst.row(y), src.row(y), src.cols);
+        }, 64);
+        return;
+    }
+
+    if (src.channels == 4)
+    {
+        parallelFor(0, src.rows, [&](int yBegin, int yEnd)
+        {
+            for (int y = yBegin; y < yEnd; y++)
+                bgraToGrayRow(src.row(y), dst.row(y), src.cols);
+        }, 16);
+        return;
+    }
+
+    if (src.channels == 3)
+        convertRows(src, dst, toGray);
+}
+
+Image imgproc::bgrToYuv(const Image& img)
+{
+    return convertImage(img, bgrToYuv, 3);
+}
+
+void imgproc::bgrToYuv(ConstImageView src, ImageView dst)
+{
+    if (!shapesMatch(src, dst, 3, 3))
+        return;
+    convertRows(src, dst, toYuv);
+}
+
+Image imgproc::yuvToBgr(const Image& img)
+{
+    return convertImage(img, yuvToBgr, 3);
+}
+
+void imgproc::yuvToBgr(ConstImageView src, ImageView dst)
+{
+    if (!shapesMatch(src, dst, 3, 3))
+        return;
+    convertRows(src, dst, fromYuv);
+}
+
+Image imgproc::bgrToHsv(const Image& img)
+{
+    return convertImage(img, bgrToHsv, 3);
+}
+
+void imgproc::bgrToHsv(ConstImageView src, ImageView dst)
+{
+    if (!shapesMatch(src, dst, 3, 3))
+        return;
+
+    // the hue sector makes this branchy per pixel, so it stays scalar; the
+    // divisions go through reciprocal tables instead
+    const HsvTables& tables = hsvTables();
+    constexpr int round = 1 << (hsvShift - 1);
+
+    parallelFor(0, src.rows, [&](int yBegin, int yEnd)
+    {
+        for (int y = yBegin; y < yEnd; y++)
+        {
+            const uint8_t* in = src.row(y);
+            uint8_t* out = dst.row(y);
+            for (int x = 0; x < src.cols; x++, in += 3, out += 3)
+            {
+                const int b = in[0], g = in[1], r = in[2];
+                const int v = std::max({ b, g, r });
+                const int diff = v - std::min({ b, g, r });
+
+                const int s = (diff * tables.sdiv[v] + round) >> hsvShift;
+
+                int h = 0;
+                if (diff != 0)
+                {
+                    if (v == r)
+                        h = g - b;
+                    else if (v == g)
+                        h = b - r + 2 * diff;
+                    else
+                        h = r - g + 4 * diff;
+
+                    h = (h * tables.hdiv[diff] + round) >> hsvShift;
+                    if (h < 0)
+                        h += 180;
+                    if (h >= 180)
+                        h -= 180;
+                }
+
+                out[0] = static_cast<uint8_t>(h);
+                out[1] = static_cast<uint8_t>(s);
+                out[2] = static_cast<uint8_t>(v);
+            }
+        }
+    }, 16);
+}
+
+Image imgproc::hsvToBgr(const Image& img)
+{
+    return convertImage(img, hsvToBgr, 3);
+}
+
+void imgproc::hsvToBgr(ConstImageView src, ImageView dst)
+{
+    if (!shapesMatch(src, dst, 3, 3))
+        return;
+
+    parallelFor(0, src.rows, [&](int yBegin, int yEnd)
+    {
+        for (int y = yBegin; y < yEnd; y++)
+        {
+            const uint8_t* in = src.row(y);
+            uint8_t* out = dst.row(y);
+            for (int x = 0; x < src.cols; x++, in += 3, out += 3)
+            {
+                // hue in sixths of the circle; 30 units per sector
+                const float h = (in[0] % 180) / 30.f;
+                const float s = in[1] / 255.f;
+                const float v = static_cast<float>(in[2]);
+
+                const int sector = static_cast<int>(h);
+                const float f = h - sector;
+                const float p = v * (1.f - s);
+                const float q = v * (1.f - s * f);
+                const float t = v * (1.f - s * (1.f - f));
+
+                float r, g, b;
+                switch (sector)
+                {
+                case 0: r = v; g = t; b = p; break;
+                case 1: r = q; g = v; b = p; break;
+                case 2: r = p; g = v; b = t; break;
+                case 3: r = p; g = q; b = v; break;
+                case 4: r = t; g = p; b = v; break;
+                default: r = v; g = p; b = q; break;
+                }
+
+                out[0] = static_cast<uint8_t>(std::min(b + 0.5f, 255.f));
+                out[1] = static_cast<uint8_t>(std::min(g + 0.5f, 255.f));
+                out[2] = static_cast<uint8_t>(std::min(r + 0.5f, 255.f));
+            }
+        }
+    }, 16);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "imgOps.h"
+
+namespace imgproc
+{
+    // Colour input is interleaved BGR (see imgOps.h). YUV is BT.601 with
+    // U and V offset by 128; as with OpenCV's 8-bit YUV, V clips for strongly
+    // saturated reds/cyans, so those do not round-trip exactly. HSV uses
+    // OpenCV's 8-bit ranges: H in [0, 180) (degrees / 2), S and V in [0, 255].
+    // Input with any other channel count than listed gives an empty image;
+    // the view forms leave dst untouched then, and when the sizes differ.
+
+    // gray = 0.299 R + 0.587 G + 0.114 B; single-channel input is copied and
+    // 4-channel BGRA converts with its alpha ignored
+    Image bgrToGray(const Image& img);
+    void bgrToGray(ConstImageView src, ImageView dst);
+
+    Image bgrToYuv(const Image& img);
+    void bgrToYuv(ConstImageView src, ImageView dst);
+
+    Image yuvToBgr(const Image& img);
+    void yuvToBgr(ConstImageView src, ImageView dst);
+
+    Image bgrToHsv(const Image& img);
+    void bgrToHsv(ConstImageView src, ImageView dst);
+
+    Image hsvToBgr(const Image& img);
+    void hsvToBgr(ConstImageView src, ImageView dst);
+}
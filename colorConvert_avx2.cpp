@@ -0,0 +1,139 @@
+// Built with -mavx2; only called after cpuid reports AVX2.
+
+#include "colorConvert_simd.h"
+
+#ifdef IMGPROC_HAVE_AVX2
+
+#include <immintrin.h>
+
+#include <algorithm>
+
+using imgproc::detail::ColorMatrix;
+
+namespace
+{
+    // same pshufb masks as the SSE4.1 kernel; AVX2 shuffles within 128-bit
+    // lanes, so each lane handles its own 16 pixels with the same masks
+    struct ShuffleMasks
+    {
+        alignas(16) int8_t deinterleave[3][3][16];
+        alignas(16) int8_t interleave[3][3][16];
+    };
+
+    constexpr ShuffleMasks makeMasks()
+    {
+        ShuffleMasks m{};
+        for (int c = 0; c < 3; c++)
+            for (int t = 0; t < 3; t++)
+                for (int i = 0; i < 16; i++)
+                {
+                    const int pos = 3 * i + c;
+                    m.deinterleave[c][t][i] = static_cast<int8_t>(pos / 16 == t ? pos % 16 : -1);
+                    const int out = 16 * t + i;
+                    m.interleave[t][c][i] = static_cast<int8_t>(out % 3 == c ? out / 3 : -1);
+                }
+        return m;
+    }
+
+    constexpr ShuffleMasks masks = makeMasks();
+
+    inline __m256i mask(const int8_t* m)
+    {
+        return _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(m)));
+    }
+
+    // 16 bytes for the low lane, 16 bytes 48 further on for the high lane
+    inline __m256i loadLanes(const uint8_t* p)
+    {
+        return _mm256_inserti128_si256(_mm256_castsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 48)), 1);
+    }
+
+    inline void storeLanes(uint8_t* p, __m256i v)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_castsi256_si128(v));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 48), _mm256_extracti128_si256(v, 1));
+    }
+
+    inline __m256i dot8(__m256i c01, __m256i c2z, __m256i w01, __m256i w2z,
+        __m256i offset, __m128i shift)
+    {
+        const __m256i acc = _mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(c01, w01),
+            _mm256_madd_epi16(c2z, w2z)), offset);
+        return _mm256_sra_epi32(acc, shift);
+    }
+}
+
+void imgproc::detail::colorMatrixRowAVX2(const uint8_t* src, uint8_t* dst, int n,
+    const ColorMatrix& m)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m128i shift = _mm_cvtsi32_si128(m.shift);
+
+    __m256i w01[3], w2z[3], offset[3];
+    for (int c = 0; c < m.outChannels; c++)
+    {
+        w01[c] = _mm256_set1_epi32(static_cast<int32_t>(
+            static_cast<uint32_t>(static_cast<uint16_t>(m.coeff[c][1])) << 16 | static_cast<uint16_t>(m.coeff[c][0])));
+        w2z[c] = _mm256_set1_epi32(static_cast<uint16_t>(m.coeff[c][2]));
+        offset[c] = _mm256_set1_epi32(m.offset[c]);
+    }
+
+    // 32 pixels: pixels 0-15 in the low lanes, 16-31 in the high lanes
+    int i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        const uint8_t* p = src + 3 * i;
+        const __m256i block[3] = { loadLanes(p), loadLanes(p + 16), loadLanes(p + 32) };
+
+        __m256i lo[3], hi[3];
+        for (int c = 0; c < 3; c++)
+        {
+            const __m256i ch = _mm256_or_si256(_mm256_or_si256(
+                _mm256_shuffle_epi8(block[0], mask(masks.deinterleave[c][0])),
+                _mm256_shuffle_epi8(block[1], mask(masks.deinterleave[c][1]))),
+                _mm256_shuffle_epi8(block[2], mask(masks.deinterleave[c][2])));
+            lo[c] = _mm256_unpacklo_epi8(ch, zero);
+            hi[c] = _mm256_unpackhi_epi8(ch, zero);
+        }
+
+        const __m256i lo01[2] = { _mm256_unpacklo_epi16(lo[0], lo[1]), _mm256_unpackhi_epi16(lo[0], lo[1]) };
+        const __m256i lo2z[2] = { _mm256_unpacklo_epi16(lo[2], zero), _mm256_unpackhi_epi16(lo[2], zero) };
+        const __m256i hi01[2] = { _mm256_unpacklo_epi16(hi[0], hi[1]), _mm256_unpackhi_epi16(hi[0], hi[1]) };
+        const __m256i hi2z[2] = { _mm256_unpacklo_epi16(hi[2], zero), _mm256_unpackhi_epi16(hi[2], zero) };
+
+        // every step is lane-wise, so packing undoes the unpacking per lane
+        __m256i out[3];
+        for (int c = 0; c < m.outChannels; c++)
+        {
+            const __m256i a = _mm256_packs_epi32(
+                dot8(lo01[0], lo2z[0], w01[c], w2z[c], offset[c], shift),
+                dot8(lo01[1], lo2z[1], w01[c], w2z[c], offset[c], shift));
+            const __m256i b = _mm256_packs_epi32(
+                dot8(hi01[0], hi2z[0], w01[c], w2z[c], offset[c], shift),
+                dot8(hi01[1], hi2z[1], w01[c], w2z[c], offset[c], shift));
+            out[c] = _mm256_packus_epi16(a, b);
+        }
+
+        if (m.outChannels == 1)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), out[0]);
+            continue;
+        }
+
+        uint8_t* q = dst + 3 * i;
+        for (int t = 0; t < 3; t++)
+        {
+            const __m256i packed = _mm256_or_si256(_mm256_or_si256(
+                _mm256_shuffle_epi8(out[0], mask(masks.interleave[t][0])),
+                _mm256_shuffle_epi8(out[1], mask(masks.interleave[t][1]))),
+                _mm256_shuffle_epi8(out[2], mask(masks.interleave[t][2])));
+            storeLanes(q + 16 * t, packed);
+        }
+    }
+
+    colorMatrixRowScalar(src + 3 * i, dst + m.outChannels * i, n - i, m);
+}
+
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+
+// Row kernel behind the linear colour conversions (gray, YUV), one per
+// instruction set. Internal to colorConvert -- not part of the public
+// imgproc API.
+
+#include <cstdint>
+
+namespace imgproc::detail
+{
+    // Fixed-point 3x3 colour matrix over interleaved 3-channel pixels:
+    //   out[c] = clamp((sum_k coeff[c][k] * in[k] + offset[c]) >> shift, 0, 255)
+    // offset carries the rounding term. With outChannels == 1 only row 0 is
+    // used and the output is single channel.
+    struct ColorMatrix
+    {
+        int16_t coeff[3][3];
+        int32_t offset[3];
+        int shift;
+        int outChannels;
+    };
+
+    // n pixels from src to dst
+    using ColorMatrixRowFn = void (*)(const uint8_t* src, uint8_t* dst, int n,
+        const ColorMatrix& m);
+
+    // best kernel that was compiled in and is allowed by simdLevel()
+    ColorMatrixRowFn selectColorMatrixRow();
+
+    void colorMatrixRowScalar(const uint8_t* src, uint8_t* dst, int n,
+        const ColorMatrix& m);
+
+    // integer arithmetic throughout, so every variant is bit-identical to
+    // the scalar path
+#ifdef IMGPROC_HAVE_SSE41
+    void colorMatrixRowSSE41(const uint8_t* src, uint8_t* dst, int n,
+        const ColorMatrix& m);
+#endif
+
+#ifdef IMGPROC_HAVE_AVX2
+    void colorMatrixRowAVX2(const uint8_t* src, uint8_t* dst, int n,
+        const ColorMatrix& m);
+#endif
+
+    // BGR -> gray for one row on the best kernel; used by fused pipelines
+    // (e.g. blurring straight from colour to gray)
+    void bgrToGrayRow(const uint8_t* src, uint8_t* dst, int n);
+}
@@ -0,0 +1,127 @@
+// Built with -msse4.1; only called after cpuid reports SSE4.1.
+
+#include "colorConvert_simd.h"
+
+#ifdef IMGPROC_HAVE_SSE41
+
+#include <smmintrin.h>
+
+#include <algorithm>
+
+using imgproc::detail::ColorMatrix;
+
+namespace
+{
+    // pshufb masks for 16 interleaved 3-channel pixels held in three
+    // registers (blocks): deinterleave[c][t] pulls channel c's bytes out of
+    // block t, interleave[t][c] places channel c's bytes into block t
+    struct ShuffleMasks
+    {
+        alignas(16) int8_t deinterleave[3][3][16];
+        alignas(16) int8_t interleave[3][3][16];
+    };
+
+    constexpr ShuffleMasks makeMasks()
+    {
+        ShuffleMasks m{};
+        for (int c = 0; c < 3; c++)
+            for (int t = 0; t < 3; t++)
+                for (int i = 0; i < 16; i++)
+                {
+                    const int pos = 3 * i + c;
+                    m.deinterleave[c][t][i] = static_cast<int8_t>(pos / 16 == t ? pos % 16 : -1);
+                    const int out = 16 * t + i;
+                    m.interleave[t][c][i] = static_cast<int8_t>(out % 3 == c ? out / 3 : -1);
+                }
+        return m;
+    }
+
+    constexpr ShuffleMasks masks = makeMasks();
+
+    inline __m128i mask(const int8_t* m)
+    {
+        return _mm_load_si128(reinterpret_cast<const __m128i*>(m));
+    }
+
+    // 4 pixels of one output channel from 16-bit channel pairs
+    inline __m128i dot4(__m128i c01, __m128i c2z, __m128i w01, __m128i w2z,
+        __m128i offset, __m128i shift)
+    {
+        const __m128i acc = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(c01, w01),
+            _mm_madd_epi16(c2z, w2z)), offset);
+        return _mm_sra_epi32(acc, shift);
+    }
+}
+
+void imgproc::detail::colorMatrixRowSSE41(const uint8_t* src, uint8_t* dst, int n,
+    const ColorMatrix& m)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i shift = _mm_cvtsi32_si128(m.shift);
+
+    __m128i w01[3], w2z[3], offset[3];
+    for (int c = 0; c < m.outChannels; c++)
+    {
+        w01[c] = _mm_set1_epi32(static_cast<int32_t>(
+            static_cast<uint32_t>(static_cast<uint16_t>(m.coeff[c][1])) << 16 | static_cast<uint16_t>(m.coeff[c][0])));
+        w2z[c] = _mm_set1_epi32(static_cast<uint16_t>(m.coeff[c][2]));
+        offset[c] = _mm_set1_epi32(m.offset[c]);
+    }
+
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i block[3] = {
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * i)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * i + 16)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * i + 32)) };
+
+        // widen each channel to 16 bits, low and high 8 pixels
+        __m128i lo[3], hi[3];
+        for (int c = 0; c < 3; c++)
+        {
+            const __m128i ch = _mm_or_si128(_mm_or_si128(
+                _mm_shuffle_epi8(block[0], mask(masks.deinterleave[c][0])),
+                _mm_shuffle_epi8(block[1], mask(masks.deinterleave[c][1]))),
+                _mm_shuffle_epi8(block[2], mask(masks.deinterleave[c][2])));
+            lo[c] = _mm_unpacklo_epi8(ch, zero);
+            hi[c] = _mm_unpackhi_epi8(ch, zero);
+        }
+
+        const __m128i lo01[2] = { _mm_unpacklo_epi16(lo[0], lo[1]), _mm_unpackhi_epi16(lo[0], lo[1]) };
+        const __m128i lo2z[2] = { _mm_unpacklo_epi16(lo[2], zero), _mm_unpackhi_epi16(lo[2], zero) };
+        const __m128i hi01[2] = { _mm_unpacklo_epi16(hi[0], hi[1]), _mm_unpackhi_epi16(hi[0], hi[1]) };
+        const __m128i hi2z[2] = { _mm_unpacklo_epi16(hi[2], zero), _mm_unpackhi_epi16(hi[2], zero) };
+
+        __m128i out[3];
+        for (int c = 0; c < m.outChannels; c++)
+        {
+            const __m128i a = _mm_packs_epi32(
+                dot4(lo01[0], lo2z[0], w01[c], w2z[c], offset[c], shift),
+                dot4(lo01[1], lo2z[1], w01[c], w2z[c], offset[c], shift));
+            const __m128i b = _mm_packs_epi32(
+                dot4(hi01[0], hi2z[0], w01[c], w2z[c], offset[c], shift),
+                dot4(hi01[1], hi2z[1], w01[c], w2z[c], offset[c], shift));
+            out[c] = _mm_packus_epi16(a, b);
+        }
+
+        if (m.outChannels == 1)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), out[0]);
+            continue;
+        }
+
+        for (int t = 0; t < 3; t++)
+        {
+            const __m128i packed = _mm_or_si128(_mm_or_si128(
+                _mm_shuffle_epi8(out[0], mask(masks.interleave[t][0])),
+                _mm_shuffle_epi8(out[1], mask(masks.interleave[t][1]))),
+                _mm_shuffle_epi8(out[2], mask(masks.interleave[t][2])));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * i + 16 * t), packed);
+        }
+    }
+
+    colorMatrixRowScalar(src + 3 * i, dst + m.outChannels * i, n - i, m);
+}
+
+#endif
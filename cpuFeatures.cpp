@@ -0,0 +1,86 @@
+#include "cpuFeatures.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    imgproc::SimdLevel detect()
+    {
+        using imgproc::SimdLevel;
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        // the builtins run cpuid and also check the OS saves the AVX state
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return SimdLevel::AVX2;
+        if (__builtin_cpu_supports("sse4.1"))
+            return SimdLevel::SSE41;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        int info[4];
+        __cpuid(info, 1);
+        const bool sse41 = (info[2] & (1 << 19)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+
+        // AVX registers are only usable if the OS saves them (XCR0 bits 1 and 2)
+        bool avx2 = false;
+        if (osxsave && avx && (_xgetbv(0) & 0x6) == 0x6)
+        {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+
+        if (avx2)
+            return SimdLevel::AVX2;
+        if (sse41)
+            return SimdLevel::SSE41;
+#endif
+        return SimdLevel::Scalar;
+    }
+
+    // highest level with kernels compiled in (none with IMGPROC_ENABLE_SIMD off)
+    constexpr imgproc::SimdLevel builtLevel()
+    {
+#if defined(IMGPROC_HAVE_AVX2)
+        return imgproc::SimdLevel::AVX2;
+#elif defined(IMGPROC_HAVE_SSE41)
+        return imgproc::SimdLevel::SSE41;
+#else
+        return imgproc::SimdLevel::Scalar;
+#endif
+    }
+
+    imgproc::SimdLevel usableLevel()
+    {
+        return std::min(imgproc::detectedSimdLevel(), builtLevel());
+    }
+
+    std::atomic<int>& currentLevel()
+    {
+        static std::atomic<int> level{ static_cast<int>(usableLevel()) };
+        return level;
+    }
+}
+
+imgproc::SimdLevel imgproc::detectedSimdLevel()
+{
+    static const SimdLevel level = detect();
+    return level;
+}
+
+imgproc::SimdLevel imgproc::simdLevel()
+{
+    return static_cast<SimdLevel>(currentLevel().load(std::memory_order_relaxed));
+}
+
+void imgproc::setSimdLevel(SimdLevel level)
+{
+    level = std::min(level, usableLevel());
+    currentLevel().store(static_cast<int>(level), std::memory_order_relaxed);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+namespace imgproc
+{
+    // Instruction sets the vectorized kernels are built for, lowest to highest.
+    enum class SimdLevel { Scalar, SSE41, AVX2 };
+
+    // highest level this CPU (and OS) supports, detected once via cpuid
+    SimdLevel detectedSimdLevel();
+
+    // level the kernels dispatch on; starts at detectedSimdLevel(), or lower
+    // when the build left those kernels out (IMGPROC_ENABLE_SIMD=OFF).
+    // requests above what the CPU supports are clamped, so forcing Scalar is
+    // always possible (e.g. to compare against the reference path).
+    SimdLevel simdLevel();
+    void setSimdLevel(SimdLevel level);
+}
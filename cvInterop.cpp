@@ -0,0 +1,171 @@
+#include "cvInterop.h"
+
+#include <opencv2/core/mat.hpp>
+
+#include <memory>
+
+namespace
+{
+	template <typename T> constexpr int matDepth();
+	template <> constexpr int matDepth<uint8_t>() { return CV_8U; }
+	template <> constexpr int matDepth<uint16_t>() { return CV_16U; }
+	template <> constexpr int matDepth<float>() { return CV_32F; }
+
+	template <typename T>
+	cv::Mat toMat(imgproc::ImageViewT<T> view)
+	{
+		if (view.empty() || view.channels <= 0)
+			return cv::Mat();
+
+		return cv::Mat(view.rows, view.cols, CV_MAKETYPE(matDepth<T>(), view.channels),
+			view.data, static_cast<size_t>(view.stride) * sizeof(T));
+	}
+
+	// the Mat only lives as long as this call, and clone() packs the rows
+	template <typename T>
+	cv::Mat copyToMat(imgproc::ImageViewT<const T> view)
+	{
+		return toMat(imgproc::ImageViewT<T>(const_cast<T*>(view.data), view.rows,
+			view.cols, view.channels, view.stride)).clone();
+	}
+
+	// the Mat header copy holds a reference on the pixel data
+	imgproc::Image borrowMat(const cv::Mat& mat)
+	{
+		if (mat.empty() || mat.depth() != CV_8U)
+			return imgproc::Image{};
+
+		auto owner = std::make_shared<const cv::Mat>(mat);
+		return imgproc::Image(imgproc::ImageView(owner->data, owner->rows, owner->cols,
+			owner->channels(), static_cast<std::ptrdiff_t>(owner->step[0])), owner);
+	}
+
+	template <typename T>
+	imgproc::ImageT<T> copyMat(const cv::Mat& mat)
+	{
+		if (mat.empty() || mat.depth() != matDepth<T>())
+			return imgproc::ImageT<T>{};
+
+		// a borrowed Image copies into a packed one
+		const imgproc::ImageT<T> borrowed(imgproc::ImageViewT<T>(
+			reinterpret_cast<T*>(mat.data), mat.rows, mat.cols, mat.channels(),
+			static_cast<std::ptrdiff_t>(mat.step[0] / sizeof(T))));
+		return imgproc::ImageT<T>(borrowed);
+	}
+}
+
+cv::Mat imgproc::imgToMat(Image &img)
+{
+	return viewToMat(img.view());
+}
+
+cv::Mat imgproc::imgToMat(const Image &img)
+{
+	return viewToMat(img.view());
+}
+
+cv::Mat imgproc::viewToMat(ImageView view)
+{
+	return toMat(view);
+}
+
+cv::Mat imgproc::viewToMat(ConstImageView view)
+{
+	return copyToMat(view);
+}
+
+imgproc::ImageView imgproc::matView(cv::Mat& mat)
+{
+	if (mat.empty() || mat.depth() != CV_8U)
+		return ImageView();
+
+	return ImageView(mat.data, mat.rows, mat.cols, mat.channels(),
+		static_cast<std::ptrdiff_t>(mat.step[0]));
+}
+
+imgproc::ConstImageView imgproc::matView(const cv::Mat& mat)
+{
+	if (mat.empty() || mat.depth() != CV_8U)
+		return ConstImageView();
+
+	return ConstImageView(mat.data, mat.rows, mat.cols, mat.channels(),
+		static_cast<std::ptrdiff_t>(mat.step[0]));
+}
+
+imgproc::Image imgproc::wrapMat(cv::Mat& mat)
+{
+	return borrowMat(mat);
+}
+
+imgproc::Image imgproc::wrapMat(cv::Mat&& mat)
+{
+	return borrowMat(mat);
+}
+
+imgproc::Image imgproc::wrapMat(const cv::Mat& mat)
+{
+	// a borrow would hand out writable pixels the Mat only lent as const
+	return matToImg(mat);
+}
+
+imgproc::Image imgproc::matToImg(const cv::Mat& mat)
+{
+	if (mat.empty() || mat.depth() != CV_8U)
+		return Image{};
+
+	// copying a borrowed Image packs it row by row, so ROIs and padded Mats
+	// come out contiguous
+	const Image borrowed = borrowMat(mat);
+	Image copy(borrowed);
+	return copy;
+}
+
+cv::Mat imgproc::imgToMat(Image16& img)
+{
+	return viewToMat(img.view());
+}
+
+cv::Mat imgproc::imgToMat(const Image16& img)
+{
+	return viewToMat(img.view());
+}
+
+cv::Mat imgproc::imgToMat(ImageF& img)
+{
+	return viewToMat(img.view());
+}
+
+cv::Mat imgproc::imgToMat(const ImageF& img)
+{
+	return viewToMat(img.view());
+}
+
+cv::Mat imgproc::viewToMat(ImageView16 view)
+{
+	return toMat(view);
+}
+
+cv::Mat imgproc::viewToMat(ConstImageView16 view)
+{
+	return copyToMat(view);
+}
+
+cv::Mat imgproc::viewToMat(ImageViewF view)
+{
+	return toMat(view);
+}
+
+cv::Mat imgproc::viewToMat(ConstImageViewF view)
+{
+	return copyToMat(view);
+}
+
+imgproc::Image16 imgproc::matToImg16(const cv::Mat& mat)
+{
+	return copyMat<uint16_t>(mat);
+}
+
+imgproc::ImageF imgproc::matToImgF(const cv::Mat& mat)
+{
+	return copyMat<float>(mat);
+}
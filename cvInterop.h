@@ -0,0 +1,48 @@
+#pragma once
+
+// OpenCV interop, kept out of imgOps.h so the core library builds and links
+// without OpenCV. Lives in the imgproc_opencv target.
+
+#include "imgOps.h"
+
+#include <opencv2/core/mat.hpp>
+
+namespace imgproc
+{
+	// imgToMat/viewToMat wrap the pixels (no copy) as a CV_8UC(channels) Mat
+	// honouring the stride; the Image must outlive the Mat. cv::Mat has no
+	// read-only form -- any header copy of it is writable -- so the const
+	// overloads return a packed copy instead of a view.
+	cv::Mat imgToMat(Image& img);
+	cv::Mat imgToMat(const Image& img);
+	cv::Mat viewToMat(ImageView view);
+	cv::Mat viewToMat(ConstImageView view);
+
+	// matView wraps an 8-bit Mat (including non-contiguous ROIs) as a view;
+	// wrapMat returns an Image borrowing the Mat's pixels and holding a
+	// reference on them, so it shares memory the way a cv::Mat header copy does.
+	// An Image is always writable, so a const Mat is copied (as matToImg)
+	// rather than borrowed; matView(const cv::Mat&) is the zero-copy,
+	// read-only way in. All yield an empty view/Image for non-8-bit Mats.
+	ImageView matView(cv::Mat& mat);
+	ConstImageView matView(const cv::Mat& mat);
+	Image wrapMat(cv::Mat& mat);
+	Image wrapMat(cv::Mat&& mat);
+	Image wrapMat(const cv::Mat& mat);
+
+	// deep copy into an owned, tightly packed Image
+	Image matToImg(const cv::Mat& mat);
+
+	// the same for 16-bit and float pixels (CV_16UC(n) and CV_32FC(n));
+	// matToImg16/matToImgF return an empty image when the depth differs
+	cv::Mat imgToMat(Image16& img);
+	cv::Mat imgToMat(const Image16& img);
+	cv::Mat imgToMat(ImageF& img);
+	cv::Mat imgToMat(const ImageF& img);
+	cv::Mat viewToMat(ImageView16 view);
+	cv::Mat viewToMat(ConstImageView16 view);
+	cv::Mat viewToMat(ImageViewF view);
+	cv::Mat viewToMat(ConstImageViewF view);
+	Image16 matToImg16(const cv::Mat& mat);
+	ImageF matToImgF(const cv::Mat& mat);
+}
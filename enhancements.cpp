@@ -1,7 +1,23 @@
 #include "enhancements.h"
+#include "colorConvert.h"
 #include "imgOps.h"
+#include "pointLut.h"
 
-#include <algorithm>
+#include <utility>
+
+namespace
+{
+	// rvalue overloads rewrite the image they were handed; borrowed pixels
+	// belong to someone else, so those still get a fresh image
+	imgproc::Image applyOwned(imgproc::Image&& img, const imgproc::PointLut& lut)
+	{
+		if (img.borrowed())
+			return lut.apply(img);
+
+		lut.applyInPlace(img);
+		return std::move(img);
+	}
+}
 
 imgproc::Image 
 imgproc::adjustBrightness(const Image& img, int beta)
@@ -12,26 +28,17 @@ imgproc::adjustBrightness(const Image& img, int beta)
 	if (beta == 0)
 		return img;
 
-	Image newImg = img;
+	return PointLut().brightness(beta).apply(img);
+}
 
-	for (int y = 0; y < img.rows; y++)
-	{
-		for (int x = 0; x < img.cols; x++)
-		{
-            Pixel oldPixel = img.getPixel(y, x);
-            
-            int r = (int)oldPixel.r + beta;
-            int g = (int)oldPixel.g + beta;
-            int b = (int)oldPixel.b + beta;
-
-            oldPixel.r = (uint8_t)(std::max(0, std::min(r, 255)));
-            oldPixel.g = (uint8_t)(std::max(0, std::min(g, 255)));
-            oldPixel.b = (uint8_t)(std::max(0, std::min(b, 255)));
-
-            newImg.setPixel(y, x, oldPixel);
-		}
-	}
-	return newImg;
+imgproc::Image imgproc::adjustBrightness(Image&& img, int beta)
+{
+	return applyOwned(std::move(img), PointLut().brightness(beta));
+}
+
+void imgproc::adjustBrightness(ConstImageView src, ImageView dst, int beta)
+{
+	PointLut().brightness(beta).apply(src, dst);
 }
 
 imgproc::Image imgproc::invert(const Image& img)
@@ -40,28 +47,17 @@ imgproc::Image imgproc::invert(const Image& img)
 	if (img.empty())
 		return img;
 
-	Image invertedImg(img.rows, img.cols, img.channels);
+	return PointLut().invert().apply(img);
+}
 
-	for (int y = 0; y < img.rows; y++)
-	{
-		for (int x = 0; x < img.cols; x++)
-		{
-            Pixel oldPixel = img.getPixel(y, x);
-			
-            int r = 255 - (int)oldPixel.r;
-            int g = 255 - (int)oldPixel.g;
-            int b = 255 - (int)oldPixel.b;
-
-            Pixel newPixel;
-            newPixel.r = (uint8_t)(std::max(0, std::min(r, 255)));
-            newPixel.g = (uint8_t)(std::max(0, std::min(g, 255)));
-            newPixel.b = (uint8_t)(std::max(0, std::min(b, 255)));
-
-            invertedImg.setPixel(y, x, newPixel);
-		}
-	}
+imgproc::Image imgproc::invert(Image&& img)
+{
+	return applyOwned(std::move(img), PointLut().invert());
+}
 
-	return invertedImg;
+void imgproc::invert(ConstImageView src, ImageView dst)
+{
+	PointLut().invert().apply(src, dst);
 }
 
 imgproc::Image imgproc::contrast(const Image& img, float alpha)
@@ -72,52 +68,49 @@ imgproc::Image imgproc::contrast(const Image& img, float alpha)
 	if (img.empty() || alpha == 0.f)
 		return img;
 
-	Image contrastImg(img.rows, img.cols, img.channels);
+	return PointLut().contrast(alpha).apply(img);
+}
+
+imgproc::Image imgproc::contrast(Image&& img, float alpha)
+{
+	if (alpha == 0.f)
+		return std::move(img);
+
+	return applyOwned(std::move(img), PointLut().contrast(alpha));
+}
+
+void imgproc::contrast(ConstImageView src, ImageView dst, float alpha)
+{
+	// alpha == 0 leaves the image as is, like the Image overloads
+	PointLut lut;
+	if (alpha != 0.f)
+		lut.contrast(alpha);
+	lut.apply(src, dst);
+}
+
+imgproc::Image imgproc::gamma(const Image& img, float g)
+{
+	// 255 * (f / 255)^g
+
+	if (img.empty() || g == 1.f)
+		return img;
+
+	return PointLut().gamma(g).apply(img);
+}
 
-	for (int y = 0; y < img.rows; y++)
-	{
-		for (int x = 0; x < img.cols; x++)
-		{	
-            Pixel oldPixel = img.getPixel(y, x);
-			
-            int r = (int)oldPixel.r * alpha;
-            int g = (int)oldPixel.g * alpha;
-            int b = (int)oldPixel.b * alpha;
-
-            Pixel newPixel;
-            newPixel.r = (uint8_t)(std::max(0, std::min(r, 255)));
-            newPixel.g = (uint8_t)(std::max(0, std::min(g, 255)));
-            newPixel.b = (uint8_t)(std::max(0, std::min(b, 255)));
-			contrastImg.setPixel(y, x, newPixel);
-		}
-	}
+imgproc::Image imgproc::gamma(Image&& img, float g)
+{
+	return applyOwned(std::move(img), PointLut().gamma(g));
+}
 
-	return contrastImg;
+void imgproc::gamma(ConstImageView src, ImageView dst, float g)
+{
+	PointLut().gamma(g).apply(src, dst);
 }
 
-//imgproc::Image imgproc::grayscale(const Image& img)
-//{
-//    if (img.empty())
-//		return img;
-//	
-//	// gray = 0.3 * R + 0.6 * G + 0.1 * B
-//	Image grayImg(img.rows, img.cols);
-//
-//	for (int y = 0; y < img.rows; y++)
-//	{
-//		for (int x = 0; x < img.cols; x++)
-//		{
-//			Pixel oldPixel = img.getPixel(y, x);
-//			
-//            float gray = 0.3 * (int)oldPixel.r + 0.6 * (int)oldPixel.g +
-//                0.1 * (int)oldPixel.b;  
-//
-//            Pixel newPixel;
-//            newPixel.r = (uint8_t)(std::max(0, std::min(r, 255)));
-//            newPixel.g = (uint8_t)(std::max(0, std::min(g, 255)));
-//            newPixel.b = (uint8_t)(std::max(0, std::min(b, 255)));
-//			contrastImg.setPixel(y, x, newPixel);
-//		}
-//	}
-//	return grayImg;
-//}
\ No newline at end of file
+imgproc::Image imgproc::grayscale(const Image& img)
+{
+	// gray = 0.299 * R + 0.587 * G + 0.114 * B, on interleaved BGR or
+	// BGRA (alpha ignored)
+	return bgrToGray(img);
+}
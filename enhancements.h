@@ -1,14 +1,30 @@
 #pragma once
 
 #include "imgOps.h"
+#include "pointLut.h"
 
 namespace imgproc
 {
+    // single point ops; chain several through PointLut to make one pass.
+    // each comes in three forms:
+    //   op(const Image&)         -> new image
+    //   op(Image&&)              -> rewrites the image it is handed (no allocation)
+    //   op(src view, dst view)   -> writes into a caller's buffer; dst may be src
     Image adjustBrightness(const Image& img, int beta);
+    Image adjustBrightness(Image&& img, int beta);
+    void adjustBrightness(ConstImageView src, ImageView dst, int beta);
 
     Image invert(const Image& img);
+    Image invert(Image&& img);
+    void invert(ConstImageView src, ImageView dst);
 
     Image contrast(const Image& img, float alpha);
+    Image contrast(Image&& img, float alpha);
+    void contrast(ConstImageView src, ImageView dst, float alpha);
+
+    Image gamma(const Image& img, float g);
+    Image gamma(Image&& img, float g);
+    void gamma(ConstImageView src, ImageView dst, float g);
 
     Image grayscale(const Image& img);
 }
\ No newline at end of file
@@ -0,0 +1,571 @@
+// Memory-mapped files and the PGM/PPM images mapped from them
+
+#include "imageIO.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace imgproc;
+
+#ifdef _WIN32
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path, Mode mode)
+{
+    const bool writable = mode == Mode::ReadWrite;
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | (writable ? GENERIC_WRITE : 0),
+        FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+    return mapHandle(file, static_cast<size_t>(size.QuadPart), writable);
+}
+
+std::shared_ptr<MappedFile> MappedFile::create(const std::string& path, size_t size)
+{
+    if (size == 0)
+        return nullptr;
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return nullptr;
+    return mapHandle(file, size, true);
+}
+
+std::shared_ptr<MappedFile> MappedFile::mapHandle(void* file, size_t size, bool writable)
+{
+    // Read mappings are copy on write, like MAP_PRIVATE; mapping a
+    // ReadWrite file past its end grows it
+    const unsigned long long size64 = size;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_WRITECOPY,
+        static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64 & 0xFFFFFFFFu), nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    void* base = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_COPY, 0, 0, size);
+    if (!base)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    std::shared_ptr<MappedFile> mapped(new MappedFile());
+    mapped->base = static_cast<uint8_t*>(base);
+    mapped->length = size;
+    mapped->file = file;
+    mapped->mapping = mapping;
+    return mapped;
+}
+
+MappedFile::~MappedFile()
+{
+    if (base)
+        UnmapViewOfFile(base);
+    if (mapping)
+        CloseHandle(mapping);
+    if (file)
+        CloseHandle(file);
+}
+
+#else
+
+namespace
+{
+    // maps all of fd; the descriptor is not needed once mapped
+    uint8_t* mapDescriptor(int fd, size_t size, bool shared)
+    {
+        void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+            shared ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+        close(fd);
+        return base == MAP_FAILED ? nullptr : static_cast<uint8_t*>(base);
+    }
+}
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path, Mode mode)
+{
+    const bool writable = mode == Mode::ReadWrite;
+    const int fd = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    const size_t size = static_cast<size_t>(info.st_size);
+    uint8_t* base = mapDescriptor(fd, size, writable);
+    if (!base)
+        return nullptr;
+
+    std::shared_ptr<MappedFile> mapped(new MappedFile());
+    mapped->base = base;
+    mapped->length = size;
+    return mapped;
+}
+
+std::shared_ptr<MappedFile> MappedFile::create(const std::string& path, size_t size)
+{
+    if (size == 0)
+        return nullptr;
+
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return nullptr;
+
+    // sized without writing it: the file stays sparse until rows land
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    uint8_t* base = mapDescriptor(fd, size, true);
+    if (!base)
+        return nullptr;
+
+    std::shared_ptr<MappedFile> mapped(new MappedFile());
+    mapped->base = base;
+    mapped->length = size;
+    return mapped;
+}
+
+MappedFile::~MappedFile()
+{
+    if (base)
+        munmap(base, length);
+}
+
+#endif
+
+namespace
+{
+    // The copying writers fill a file beside path and rename it over path
+    // once it is complete. Truncating path first would zero the pages of a
+    // source Image mapped from that same file.
+    std::string tempPathFor(const std::string& path)
+    {
+        return path + ".tmp";
+    }
+
+    // moves tmp over path; on failure tmp is removed and path left alone
+    bool replaceFile(const std::string& tmp, const std::string& path)
+    {
+#ifdef _WIN32
+        const bool moved = MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        const bool moved = std::rename(tmp.c_str(), path.c_str()) == 0;
+#endif
+        if (!moved)
+            std::remove(tmp.c_str());
+        return moved;
+    }
+}
+
+namespace
+{
+    struct PnmHeader
+    {
+        int rows = 0;
+        int cols = 0;
+        int channels = 0;
+        size_t offset = 0; // first pixel byte
+    };
+
+    // P5/P6 header: magic, width, height, maxval, separated by whitespace
+    // and '#' comments, then exactly one whitespace byte before the pixels
+    bool parsePnmHeader(const uint8_t* data, size_t size, PnmHeader& header)
+    {
+        if (size < 2 || data[0] != 'P' || (data[1] != '5' && data[1] != '6'))
+            return false;
+
+        size_t pos = 2;
+        auto number = [&](long long& value)
+        {
+            for (;;)
+            {
+                while (pos < size && std::isspace(data[pos]))
+                    pos++;
+                if (pos < size && data[pos] == '#')
+                {
+                    while (pos < size && data[pos] != '\n')
+                        pos++;
+                    continue;
+                }
+                break;
+            }
+
+            if (pos >= size || !std::isdigit(data[pos]))
+                return false;
+            value = 0;
+            while (pos < size && std::isdigit(data[pos]) && value <= 0x7FFFFFFF)
+                value = value * 10 + (data[pos++] - '0');
+            return value <= 0x7FFFFFFF;
+        };
+
+        long long cols, rows, maxval;
+        if (!number(cols) || !number(rows) || !number(maxval))
+            return false;
+        if (cols <= 0 || rows <= 0 || maxval <= 0 || maxval > 255)
+            return false;
+        if (pos >= size || !std::isspace(data[pos]))
+            return false;
+
+        header.cols = static_cast<int>(cols);
+        header.rows = static_cast<int>(rows);
+        header.channels = data[1] == '5' ? 1 : 3;
+        header.offset = pos + 1;
+
+        const size_t bytes = static_cast<size_t>(rows) * static_cast<size_t>(cols) * header.channels;
+        return header.offset <= size && bytes <= size - header.offset;
+    }
+}
+
+Image imgproc::mapPnm(const std::string& path, MappedFile::Mode mode)
+{
+    std::shared_ptr<MappedFile> file = MappedFile::open(path, mode);
+    if (!file)
+        return Image{};
+
+    PnmHeader header;
+    if (!parsePnmHeader(file->data(), file->size(), header))
+        return Image{};
+
+    const ImageView pixels(file->data() + header.offset, header.rows, header.cols,
+        header.channels, static_cast<std::ptrdiff_t>(header.cols) * header.channels);
+    return Image(pixels, std::move(file));
+}
+
+Image imgproc::createPnm(const std::string& path, int rows, int cols, int channels)
+{
+    if (rows <= 0 || cols <= 0 || (channels != 1 && channels != 3))
+        return Image{};
+
+    const std::string header = (channels == 1 ? "P5\n" : "P6\n")
+        + std::to_string(cols) + " " + std::to_string(rows) + "\n255\n";
+    const size_t bytes = static_cast<size_t>(rows) * cols * channels;
+
+    std::shared_ptr<MappedFile> file = MappedFile::create(path, header.size() + bytes);
+    if (!file)
+        return Image{};
+    std::memcpy(file->data(), header.data(), header.size());
+
+    const ImageView pixels(file->data() + header.size(), rows, cols, channels,
+        static_cast<std::ptrdiff_t>(cols) * channels);
+    return Image(pixels, std::move(file));
+}
+
+Image imgproc::readPnm(const std::string& path)
+{
+    const Image mapped = mapPnm(path);
+    if (mapped.empty())
+        return Image{};
+
+    Image img(mapped.rows, mapped.cols, mapped.channels, ImageInit::Uninitialized);
+    for (int y = 0; y < img.rows; y++)
+    {
+        const uint8_t* src = mapped.row(y);
+        uint8_t* dst = img.row(y);
+        if (img.channels == 1)
+            std::memcpy(dst, src, static_cast<size_t>(img.cols));
+        else
+            for (int x = 0; x < img.cols; x++, src += 3, dst += 3)
+            {
+                dst[0] = src[2];
+                dst[1] = src[1];
+                dst[2] = src[0];
+            }
+    }
+    return img;
+}
+
+bool imgproc::writePnm(const std::string& path, const Image& img)
+{
+    if (img.empty() || (img.channels != 1 && img.channels != 3))
+        return false;
+
+    const std::string tmp = tempPathFor(path);
+    Image file = createPnm(tmp, img.rows, img.cols, img.channels);
+    if (file.empty())
+    {
+        std::remove(tmp.c_str());
+        return false;
+    }
+
+    for (int y = 0; y < img.rows; y++)
+    {
+        const uint8_t* src = img.row(y);
+        uint8_t* dst = file.row(y);
+        if (img.channels == 1)
+            std::memcpy(dst, src, static_cast<size_t>(img.cols));
+        else
+            for (int x = 0; x < img.cols; x++, src += 3, dst += 3)
+            {
+                dst[0] = src[2];
+                dst[1] = src[1];
+                dst[2] = src[0];
+            }
+    }
+
+    // unmapped before the rename, which Windows requires
+    file = Image{};
+    return replaceFile(tmp, path);
+}
+
+namespace
+{
+    constexpr char rawMagic[8] = { 'C', 'V', 'F', 'P', 'R', 'A', 'W', '1' };
+    constexpr size_t rawHeaderBytes = 16;
+    constexpr size_t rawLevelBytes = 32;
+    constexpr size_t rawAlign = 64;
+
+    template <typename T>
+    constexpr PixelType pixelTypeOf()
+    {
+        if constexpr (std::is_same_v<T, uint8_t>)
+            return PixelType::UInt8;
+        else if constexpr (std::is_same_v<T, uint16_t>)
+            return PixelType::UInt16;
+        else
+            return PixelType::Float32;
+    }
+
+    // 0 for an unknown type
+    size_t elementSize(uint32_t type)
+    {
+        switch (static_cast<PixelType>(type))
+        {
+        case PixelType::UInt8: return 1;
+        case PixelType::UInt16: return 2;
+        case PixelType::Float32: return 4;
+        }
+        return 0;
+    }
+
+    // header fields are little-endian whatever the host
+    void put32(uint8_t* p, uint32_t v)
+    {
+        for (int i = 0; i < 4; i++)
+            p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+
+    void put64(uint8_t* p, uint64_t v)
+    {
+        for (int i = 0; i < 8; i++)
+            p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+
+    uint32_t get32(const uint8_t* p)
+    {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; i++)
+            v |= static_cast<uint32_t>(p[i]) << (8 * i);
+        return v;
+    }
+
+    uint64_t get64(const uint8_t* p)
+    {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++)
+            v |= static_cast<uint64_t>(p[i]) << (8 * i);
+        return v;
+    }
+
+    struct RawLevel
+    {
+        int rows = 0;
+        int cols = 0;
+        int channels = 0;
+        uint32_t type = 0;
+        uint64_t stride = 0; // bytes
+        uint64_t offset = 0;
+    };
+
+    // false unless every level lies inside the file, rows and all
+    bool parseRawHeader(const uint8_t* data, size_t size, std::vector<RawLevel>& levels)
+    {
+        if (size < rawHeaderBytes || std::memcmp(data, rawMagic, sizeof(rawMagic)) != 0)
+            return false;
+
+        const uint32_t count = get32(data + 8);
+        if (count == 0 || count > (size - rawHeaderBytes) / rawLevelBytes)
+            return false;
+
+        levels.resize(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const uint8_t* entry = data + rawHeaderBytes + i * rawLevelBytes;
+            const int32_t rows = static_cast<int32_t>(get32(entry));
+            const int32_t cols = static_cast<int32_t>(get32(entry + 4));
+            const int32_t channels = static_cast<int32_t>(get32(entry + 8));
+            RawLevel& level = levels[i];
+            level.type = get32(entry + 12);
+            level.stride = get64(entry + 16);
+            level.offset = get64(entry + 24);
+
+            const size_t element = elementSize(level.type);
+            if (rows <= 0 || cols <= 0 || channels <= 0 || element == 0)
+                return false;
+            level.rows = rows;
+            level.cols = cols;
+            level.channels = channels;
+
+            // aligned for T, and the last row ends inside the file
+            const uint64_t rowBytes = static_cast<uint64_t>(cols) * static_cast<uint64_t>(channels) * element;
+            if (level.stride < rowBytes || level.stride % element != 0 || level.offset % element != 0)
+                return false;
+            if (level.offset > size || rowBytes > size - level.offset
+                || static_cast<uint64_t>(rows - 1) > (size - level.offset - rowBytes) / level.stride)
+                return false;
+        }
+        return true;
+    }
+
+    template <typename T>
+    bool writeRawLevels(const std::string& path, const std::vector<const ImageT<T>*>& levels)
+    {
+        if (levels.empty())
+            return false;
+        for (const ImageT<T>* img : levels)
+            if (img->empty())
+                return false;
+
+        std::vector<RawLevel> table(levels.size());
+        size_t size = rawHeaderBytes + levels.size() * rawLevelBytes;
+        for (size_t i = 0; i < levels.size(); i++)
+        {
+            const ImageT<T>& img = *levels[i];
+            RawLevel& level = table[i];
+            level.rows = img.rows;
+            level.cols = img.cols;
+            level.channels = img.channels;
+            level.type = static_cast<uint32_t>(pixelTypeOf<T>());
+            level.stride = static_cast<uint64_t>(img.cols) * img.channels * sizeof(T);
+            level.offset = (size + rawAlign - 1) / rawAlign * rawAlign;
+            size = static_cast<size_t>(level.offset + level.stride * img.rows);
+        }
+
+        const std::string tmp = tempPathFor(path);
+        std::shared_ptr<MappedFile> file = MappedFile::create(tmp, size);
+        if (!file)
+        {
+            std::remove(tmp.c_str());
+            return false;
+        }
+
+        uint8_t* data = file->data();
+        std::memcpy(data, rawMagic, sizeof(rawMagic));
+        put32(data + 8, static_cast<uint32_t>(levels.size()));
+        put32(data + 12, 0);
+        for (size_t i = 0; i < levels.size(); i++)
+        {
+            const RawLevel& level = table[i];
+            uint8_t* entry = data + rawHeaderBytes + i * rawLevelBytes;
+            put32(entry, static_cast<uint32_t>(level.rows));
+            put32(entry + 4, static_cast<uint32_t>(level.cols));
+            put32(entry + 8, static_cast<uint32_t>(level.channels));
+            put32(entry + 12, level.type);
+            put64(entry + 16, level.stride);
+            put64(entry + 24, level.offset);
+
+            // the padding before a level was zeroed by create()
+            const ImageT<T>& img = *levels[i];
+            for (int y = 0; y < img.rows; y++)
+                std::memcpy(data + level.offset + y * level.stride, img.row(y), level.stride);
+        }
+
+        file.reset();
+        return replaceFile(tmp, path);
+    }
+
+    template <typename T>
+    ImageT<T> rawLevelImage(const std::shared_ptr<MappedFile>& file, const RawLevel& level)
+    {
+        const ImageViewT<T> pixels(reinterpret_cast<T*>(file->data() + level.offset),
+            level.rows, level.cols, level.channels,
+            static_cast<std::ptrdiff_t>(level.stride / sizeof(T)));
+        return ImageT<T>(pixels, file);
+    }
+}
+
+template <typename T>
+bool imgproc::writeRawFrame(const std::string& path, const ImageT<T>& img)
+{
+    return writeRawLevels<T>(path, { &img });
+}
+
+template <typename T>
+bool imgproc::writeRawFrame(const std::string& path, const std::vector<ImageT<T>>& levels)
+{
+    std::vector<const ImageT<T>*> pointers;
+    for (const ImageT<T>& level : levels)
+        pointers.push_back(&level);
+    return writeRawLevels<T>(path, pointers);
+}
+
+template <typename T>
+imgproc::ImageT<T> imgproc::mapRawFrame(const std::string& path, int level, MappedFile::Mode mode)
+{
+    std::shared_ptr<MappedFile> file = MappedFile::open(path, mode);
+    std::vector<RawLevel> levels;
+    if (!file || !parseRawHeader(file->data(), file->size(), levels))
+        return ImageT<T>{};
+    if (level < 0 || level >= static_cast<int>(levels.size())
+        || levels[level].type != static_cast<uint32_t>(pixelTypeOf<T>()))
+        return ImageT<T>{};
+    return rawLevelImage<T>(file, levels[level]);
+}
+
+template <typename T>
+std::vector<imgproc::ImageT<T>> imgproc::mapRawPyramid(const std::string& path, MappedFile::Mode mode)
+{
+    std::shared_ptr<MappedFile> file = MappedFile::open(path, mode);
+    std::vector<RawLevel> levels;
+    if (!file || !parseRawHeader(file->data(), file->size(), levels))
+        return {};
+
+    std::vector<ImageT<T>> images;
+    for (const RawLevel& level : levels)
+    {
+        if (level.type != static_cast<uint32_t>(pixelTypeOf<T>()))
+            return {};
+        images.push_back(rawLevelImage<T>(file, level));
+    }
+    return images;
+}
+
+#define IMGPROC_RAW_FRAME(T) \
+    template bool imgproc::writeRawFrame<T>(const std::string&, const ImageT<T>&); \
+    template bool imgproc::writeRawFrame<T>(const std::string&, const std::vector<ImageT<T>>&); \
+    template imgproc::ImageT<T> imgproc::mapRawFrame<T>(const std::string&, int, MappedFile::Mode); \
+    template std::vector<imgproc::ImageT<T>> imgproc::mapRawPyramid<T>(const std::string&, MappedFile::Mode);
+IMGPROC_RAW_FRAME(uint8_t)
+IMGPROC_RAW_FRAME(uint16_t)
+IMGPROC_RAW_FRAME(float)
+#undef IMGPROC_RAW_FRAME
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "imgOps.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace imgproc
+{
+    // A file mapped into memory, unmapped when the last reference goes.
+    // Pages are read in as they are touched and, being backed by the file,
+    // can be dropped again under memory pressure -- so a mapping can be far
+    // bigger than RAM.
+    // Read: writes through data() stay private to this process (copy on write).
+    // ReadWrite: writes go to the file.
+    class MappedFile
+    {
+    public:
+        enum class Mode { Read, ReadWrite };
+
+        // nullptr if the file cannot be opened or mapped (or is empty)
+        static std::shared_ptr<MappedFile> open(const std::string& path,
+            Mode mode = Mode::Read);
+        // creates or truncates path to `size` bytes, mapped ReadWrite
+        static std::shared_ptr<MappedFile> create(const std::string& path,
+            size_t size);
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        uint8_t* data() const { return base; }
+        size_t size() const { return length; }
+
+    private:
+        MappedFile() = default;
+
+        uint8_t* base = nullptr;
+        size_t length = 0;
+#ifdef _WIN32
+        static std::shared_ptr<MappedFile> mapHandle(void* file, size_t size, bool writable);
+
+        void* file = nullptr;
+        void* mapping = nullptr;
+#endif
+    };
+
+    // Binary PGM (P5, 1 channel) and PPM (P6, 3 channels) with maxval <= 255,
+    // mapped rather than read: the Image borrows the file's pixels and keeps
+    // the mapping alive, so opening a gigapixel scan costs nothing until its
+    // rows are touched. PPM pixels stay in the file's RGB order.
+    // Empty Image if the file is missing, truncated or not 8-bit P5/P6.
+    Image mapPnm(const std::string& path,
+        MappedFile::Mode mode = MappedFile::Mode::Read);
+    // creates a P5 (1 channel) or P6 (3 channels) file of the given size and
+    // returns its pixels mapped for writing; empty Image on failure
+    Image createPnm(const std::string& path, int rows, int cols, int channels);
+
+    // Copying PGM/PPM I/O for interchange: readPnm gives an owned, packed
+    // Image with PPM pixels swapped to BGR, writePnm writes 1-channel
+    // images as P5 and 3-channel (BGR) ones as P6. Empty Image / false on
+    // failure. writePnm fills path + ".tmp" and renames it over path, so img
+    // may be mapped from path itself.
+    Image readPnm(const std::string& path);
+    bool writePnm(const std::string& path, const Image& img);
+
+    // Raw frames: a small header and the pixels as they sit in memory, so
+    // a frame (or a whole cached pyramid) is mapped straight back as Images
+    // with no decoding and no copy. A file holds one or more levels -- the
+    // image, then optionally its pyramid levels -- each with its own size,
+    // channels, element type and row stride in bytes. Multi-byte values are
+    // little-endian.
+    //
+    //   0   "CVFPRAW1"
+    //   8   uint32 level count
+    //   12  uint32 0
+    //   16  per level, 32 bytes: int32 rows, cols, channels, uint32 type
+    //       (PixelType), uint64 stride, uint64 offset of row 0 from the
+    //       start of the file
+    //
+    // writeRawFrame starts each level on a 64-byte boundary with packed
+    // rows; readers take any stride that holds a row and is a multiple of
+    // the element size.
+    enum class PixelType : uint32_t { UInt8 = 1, UInt16 = 2, Float32 = 3 };
+
+    // false on failure; like writePnm, writes path + ".tmp" and renames it
+    // over path, so the levels may be mapped from path itself
+    template <typename T>
+    bool writeRawFrame(const std::string& path, const ImageT<T>& img);
+    template <typename T>
+    bool writeRawFrame(const std::string& path, const std::vector<ImageT<T>>& levels);
+
+    // level `level` of a raw frame file, borrowing the mapped pixels (see
+    // mapPnm for the modes); empty Image if the file is missing, malformed,
+    // has no such level or the level's type is not T
+    template <typename T>
+    ImageT<T> mapRawFrame(const std::string& path, int level = 0,
+        MappedFile::Mode mode = MappedFile::Mode::Read);
+    // every level, sharing one mapping; empty if any level is not of type T
+    template <typename T>
+    std::vector<ImageT<T>> mapRawPyramid(const std::string& path,
+        MappedFile::Mode mode = MappedFile::Mode::Read);
+}
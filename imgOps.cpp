@@ -1,66 +1,183 @@
 // basic operations
 
 #include "imgOps.h"
-#include <opencv2/core/hal/interface.h>
-#include <opencv2/opencv.hpp>
+#include "parallel.h"
 
-// helper functions
-cv::Mat imgproc::imgToMat(Image &img)
+#include <cstring>
+#include <stdexcept>
+
+template <typename T>
+imgproc::ImageT<T>::ImageT(ImageViewT<T> borrowed, std::shared_ptr<const void> owner)
+: rows(borrowed.rows), cols(borrowed.cols), channels(borrowed.channels),
+  external(borrowed.data), externalStride(borrowed.stride), keepAlive(std::move(owner))
+{
+}
+
+template <typename T>
+imgproc::ImageT<T>::ImageT(const ImageT& other)
+: rows(other.rows), cols(other.cols), channels(other.channels)
+{
+	if (!other.borrowed())
+	{
+		pixels = other.pixels;
+		return;
+	}
+
+	pixels.resize(static_cast<size_t>(rows) * cols * channels);
+	const size_t rowBytes = static_cast<size_t>(cols) * channels * sizeof(T);
+	for (int y = 0; y < rows; y++)
+		std::memcpy(row(y), other.row(y), rowBytes);
+}
+
+template <typename T>
+imgproc::ImageT<T>::ImageT(ImageT&& other) noexcept
+: rows(other.rows), cols(other.cols), channels(other.channels),
+  pixels(std::move(other.pixels)), external(other.external),
+  externalStride(other.externalStride), keepAlive(std::move(other.keepAlive))
 {
-	int nChannels = 0;
-	if (img.channels == 3)
-		nChannels = CV_8UC3;
-	else if (img.channels == 1)
-		nChannels = CV_8UC1;
-
-	return cv::Mat(img.rows, img.cols, nChannels,
-			img.pixels.data());
+	other.rows = other.cols = other.channels = 0;
+	other.pixels.clear();
+	other.external = nullptr;
+	other.externalStride = 0;
 }
 
-imgproc::Image imgproc::matToImg(const cv::Mat& mat)
+template <typename T>
+imgproc::ImageT<T>& imgproc::ImageT<T>::operator=(const ImageT& other)
 {
-	Image img;
-	img.rows = mat.rows;
-	img.cols = mat.cols;
-	img.channels = mat.channels();
-	img.pixels = { mat.data, mat.data + mat.total() * mat.elemSize() };
+	if (this != &other)
+		*this = ImageT(other);
+	return *this;
+}
+
+template <typename T>
+imgproc::ImageT<T>& imgproc::ImageT<T>::operator=(ImageT&& other) noexcept
+{
+	if (this == &other)
+		return *this;
+
+	rows = other.rows;
+	cols = other.cols;
+	channels = other.channels;
+	pixels = std::move(other.pixels);
+	external = other.external;
+	externalStride = other.externalStride;
+	keepAlive = std::move(other.keepAlive);
 
-	return img;
+	other.rows = other.cols = other.channels = 0;
+	other.pixels.clear();
+	other.external = nullptr;
+	other.externalStride = 0;
+	return *this;
 }
 
-imgproc::Pixel
-imgproc::Image::getPixel(int y, int x) const
+template <typename T>
+imgproc::PixelT<T>
+imgproc::ImageT<T>::getPixel(int y, int x) const
 {
-	int idx =  (x + cols * y) * channels;
-	Pixel pixel{};
-	if (channels == 3)
+	if (y < 0 || x < 0 || y >= rows || x >= cols)
+		throw std::out_of_range("imgproc::Image::getPixel");
+
+	const T* p = row(y) + x * channels;
+	PixelT<T> pixel{};
+	if (channels >= 3)
 	{
-		pixel.r = pixels.at(idx);
-		pixel.g = pixels.at(idx + 1);
-		pixel.b = pixels.at(idx + 2);
+		pixel.r = p[0];
+		pixel.g = p[1];
+		pixel.b = p[2];
+		if (channels == 4)
+			pixel.a = p[3];
 	}
 	else if (channels == 1)
 	{
-		pixel.r = pixels.at(idx);
+		pixel.r = p[0];
 	}
 	return pixel;
 }
 
-void imgproc::Image::setPixel(int y, int x, const Pixel& pixel)
+template <typename T>
+void imgproc::ImageT<T>::setPixel(int y, int x, const PixelT<T>& pixel)
 {
-	int idx =  (x + cols * y) * channels;
-	
-	if (channels == 3)
+	if (y < 0 || x < 0 || y >= rows || x >= cols)
+		throw std::out_of_range("imgproc::Image::setPixel");
+
+	T* p = row(y) + x * channels;
+	if (channels >= 3)
 	{
-		pixels.at(idx) = pixel.r;
-		pixels.at(idx + 1) = pixel.g;
-		pixels.at(idx + 2) = pixel.b;
+		p[0] = pixel.r;
+		p[1] = pixel.g;
+		p[2] = pixel.b;
+		if (channels == 4)
+			p[3] = pixel.a;
 	}
 	else if (channels == 1)
 	{
-		pixels.at(idx) = pixel.r;
+		p[0] = pixel.r;
 	}
 }
 
+template struct imgproc::ImageT<uint8_t>;
+template struct imgproc::ImageT<uint16_t>;
+template struct imgproc::ImageT<float>;
+
+template <typename U, typename T>
+imgproc::ImageT<U> imgproc::convertTo(const ImageT<T>& img, float scale, float offset)
+{
+	if (img.empty())
+		return ImageT<U>{};
+
+	ImageT<U> out(img.rows, img.cols, img.channels, ImageInit::Uninitialized);
+	const int rowElems = img.cols * img.channels;
+	parallelFor(0, img.rows, [&](int yBegin, int yEnd)
+	{
+		for (int y = yBegin; y < yEnd; y++)
+		{
+			const T* src = img.row(y);
+			U* dst = out.row(y);
+			for (int i = 0; i < rowElems; i++)
+				dst[i] = saturateCast<U>(static_cast<float>(src[i]) * scale + offset);
+		}
+	}, 16);
+	return out;
+}
 
+#define IMGPROC_CONVERT_TO(U, T) \
+	template imgproc::ImageT<U> imgproc::convertTo<U, T>(const ImageT<T>&, float, float);
+IMGPROC_CONVERT_TO(uint8_t, uint8_t)
+IMGPROC_CONVERT_TO(uint8_t, uint16_t)
+IMGPROC_CONVERT_TO(uint8_t, float)
+IMGPROC_CONVERT_TO(uint16_t, uint8_t)
+IMGPROC_CONVERT_TO(uint16_t, uint16_t)
+IMGPROC_CONVERT_TO(uint16_t, float)
+IMGPROC_CONVERT_TO(float, uint8_t)
+IMGPROC_CONVERT_TO(float, uint16_t)
+IMGPROC_CONVERT_TO(float, float)
+#undef IMGPROC_CONVERT_TO
 
+void imgproc::embed(ConstImageView src, ImageView dst, int y, int x)
+{
+	const size_t dstRowBytes = static_cast<size_t>(dst.rowElems());
+	const size_t leftBytes = static_cast<size_t>(x) * dst.channels;
+	const size_t srcRowBytes = static_cast<size_t>(src.rowElems());
+	const size_t rightBytes = dstRowBytes - leftBytes - srcRowBytes;
+
+	parallelFor(0, dst.rows, [&](int yBegin, int yEnd)
+	{
+		for (int r = yBegin; r < yEnd; r++)
+		{
+			uint8_t* out = dst.row(r);
+			if (r < y || r >= y + src.rows)
+			{
+				std::memset(out, 0, dstRowBytes);
+				continue;
+			}
+
+			std::memset(out, 0, leftBytes);
+			std::memcpy(out + leftBytes, src.row(r - y), srcRowBytes);
+			std::memset(out + leftBytes + srcRowBytes, 0, rightBytes);
+		}
+	}, 64);
+
+	const size_t borderBytes = static_cast<size_t>(dst.rows) * dstRowBytes
+		- static_cast<size_t>(src.rows) * srcRowBytes;
+	detail::countZeroed(borderBytes);
+}
@@ -1,7 +1,13 @@
 #pragma once
 
-#include <opencv2/core/mat.hpp>
+#include "bufferPool.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
 #include <vector>
 
 // Pixels are stored in a single contigous buffer.  If color, they are interleaved BGR (from openCV).
@@ -9,6 +15,8 @@
 	
 namespace imgproc
 {
+	static constexpr double PI = 3.14159265358979323846;
+
 	template <typename T>
 	struct Point
 	{
@@ -17,15 +25,88 @@ namespace imgproc
 		Point(T _x, T _y) : x(_x), y(_y) {}
 	};
 
-	struct Pixel
+	// channels in storage order; 1-channel images only use r, 3-channel
+	// ones r, g and b, and 4-channel ones all four
+	template <typename T>
+	struct PixelT
+	{
+		T r, g, b, a;
+	};
+	using Pixel = PixelT<uint8_t>;
+
+	// One row of interleaved pixels with the channel count fixed at compile time,
+	// so px[x] is a plain pointer bump with no per-pixel channel branch.
+	template <typename T, int C>
+	struct PixelRow
+	{
+		T* data = nullptr;
+		int cols = 0;
+
+		T* operator[](int x) const { return data + x * C; }
+		T* begin() const { return data; }
+		T* end() const { return data + cols * C; }
+	};
+
+	// Non-owning, stride-aware window onto interleaved pixel rows.
+	// stride is the distance between row starts in elements; it is at least
+	// cols * channels, larger when the view is a sub-rectangle of a bigger buffer.
+	// No bounds checking -- this is what the hot loops use.
+	template <typename T>
+	struct ImageViewT
 	{
-		uint8_t r, g, b;
+		T* data = nullptr;
+		int rows = 0;
+		int cols = 0;
+		int channels = 0;
+		std::ptrdiff_t stride = 0;
+
+		ImageViewT() = default;
+		ImageViewT(T* _data, int _rows, int _cols, int _channels, std::ptrdiff_t _stride)
+		: data(_data), rows(_rows), cols(_cols), channels(_channels), stride(_stride) {}
+
+		// mutable view -> const view
+		template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+		ImageViewT(const ImageViewT<U>& other)
+		: data(other.data), rows(other.rows), cols(other.cols),
+		  channels(other.channels), stride(other.stride) {}
+
+		T* row(int y) const { return data + y * stride; }
+		T* ptr(int y, int x) const { return row(y) + x * channels; }
+
+		template <int C>
+		PixelRow<T, C> pixelRow(int y) const { return { row(y), cols }; }
+
+		// elements actually holding pixel data in each row
+		int rowElems() const { return cols * channels; }
+
+		// sub-rectangle sharing the same memory
+		ImageViewT roi(int y, int x, int height, int width) const
+		{
+			return ImageViewT(ptr(y, x), height, width, channels, stride);
+		}
+
+		bool empty() const { return data == nullptr || rows == 0 || cols == 0; }
 	};
 
-	struct Image
+	using ImageView = ImageViewT<uint8_t>;
+	using ConstImageView = ImageViewT<const uint8_t>;
+
+	// Zero: every pixel starts black (what canvases with empty borders need).
+	// Uninitialized: contents are garbage; for stages that overwrite every pixel.
+	enum class ImageInit { Zero, Uninitialized };
+
+	// Owned (or borrowed) interleaved pixels of element type T -- uint8_t,
+	// uint16_t or float; the channel count is per image. Image is the 8-bit
+	// case every op supports; Image16 and ImageF carry data that would lose
+	// precision through uint8 (see convertTo and applyGuassian).
+	template <typename T>
+	struct ImageT
 	{
-		Image() = default;
-		Image(const int _rows, const int _cols, const int _channels)
+		using value_type = T;
+
+		ImageT() = default;
+		ImageT(const int _rows, const int _cols, const int _channels,
+			const ImageInit init = ImageInit::Zero)
 		: rows(_rows), cols(_cols), channels(_channels) 
 		{
 			/*
@@ -63,23 +144,113 @@ namespace imgproc
 
 			*/
 			
-			pixels.resize(rows * cols * channels, 0);
+			const size_t n = static_cast<size_t>(rows) * cols * channels;
+			if (init == ImageInit::Zero)
+			{
+				pixels.resize(n, T{});
+				detail::countZeroed(n * sizeof(T));
+			}
+			else
+				pixels.resize(n);
 		}
 
+		// Borrow externally owned pixels (a cv::Mat, an mmap'd file, a decoder
+		// frame) without copying. borrowed.stride may exceed cols * channels,
+		// e.g. for a ROI of a larger buffer. owner, if given, is held for the
+		// Image's lifetime to keep that memory alive.
+		// Copying a borrowed Image makes an owned, tightly packed copy;
+		// moving it keeps the borrow.
+		explicit ImageT(ImageViewT<T> borrowed, std::shared_ptr<const void> owner = nullptr);
+
+		ImageT(const ImageT& other);
+		ImageT(ImageT&& other) noexcept;
+		ImageT& operator=(const ImageT& other);
+		ImageT& operator=(ImageT&& other) noexcept;
+		~ImageT() = default;
+
 		int rows = 0;
 		int cols = 0;
 		int channels = 0;
-		std::vector<uint8_t> pixels;
+		PixelBufferT<T> pixels; // owned storage; empty while borrowing
 			
-		Pixel getPixel(int y, int x) const;
+		PixelT<T> getPixel(int y, int x) const;
 
 		void setPixel(int y, int x,
-			const Pixel& pixel);
+			const PixelT<T>& pixel);
 
-		bool empty() const { return pixels.empty(); }
+		bool empty() const { return borrowed() ? (rows == 0 || cols == 0) : pixels.empty(); }
+		bool borrowed() const { return external != nullptr; }
+
+		// unchecked row access; stride is in elements
+		T* data() { return borrowed() ? external : pixels.data(); }
+		const T* data() const { return borrowed() ? external : pixels.data(); }
+		std::ptrdiff_t stride() const
+		{
+			return borrowed() ? externalStride : static_cast<std::ptrdiff_t>(cols) * channels;
+		}
+		T* row(int y) { return data() + y * stride(); }
+		const T* row(int y) const { return data() + y * stride(); }
+
+		ImageViewT<T> view() { return ImageViewT<T>(data(), rows, cols, channels, stride()); }
+		ImageViewT<const T> view() const { return ImageViewT<const T>(data(), rows, cols, channels, stride()); }
+
+	private:
+		T* external = nullptr;
+		std::ptrdiff_t externalStride = 0;
+		std::shared_ptr<const void> keepAlive;
 	};
 
-	cv::Mat imgToMat(Image& img);
-	Image matToImg(const cv::Mat& mat);
+	using Image = ImageT<uint8_t>;
+	using Image16 = ImageT<uint16_t>;
+	using ImageF = ImageT<float>;
+
+	using ImageView16 = ImageViewT<uint16_t>;
+	using ConstImageView16 = ImageViewT<const uint16_t>;
+	using ImageViewF = ImageViewT<float>;
+	using ConstImageViewF = ImageViewT<const float>;
+
+	// the out-of-line members are built in imgOps.cpp for these types only
+	extern template struct ImageT<uint8_t>;
+	extern template struct ImageT<uint16_t>;
+	extern template struct ImageT<float>;
+
+	// v rounded to nearest and clamped to T's range (floats pass through)
+	template <typename T>
+	inline T saturateCast(float v)
+	{
+		if constexpr (std::is_floating_point_v<T>)
+			return static_cast<T>(v);
+		else
+			return static_cast<T>(std::clamp(v + 0.5f, 0.f,
+				static_cast<float>(std::numeric_limits<T>::max())));
+	}
+
+	// dst = saturateCast<U>(src * scale + offset), e.g.
+	// convertTo<float>(img, 1 / 255.f) for floats in [0, 1] and
+	// convertTo<uint8_t>(imgF, 255.f) for the way back
+	template <typename U, typename T>
+	ImageT<U> convertTo(const ImageT<T>& img, float scale = 1.f, float offset = 0.f);
+
+	// calls f(std::integral_constant<int, C>()) with C = channels for the
+	// common counts 1, 3 and 4, and C = 0 for anything else. Kernels written
+	// as template <int C> get compile-time channel loops without a switch of
+	// their own (C == 0 means "read the count at runtime").
+	template <typename F>
+	decltype(auto) withChannels(int channels, F&& f)
+	{
+		switch (channels)
+		{
+		case 1: return f(std::integral_constant<int, 1>());
+		case 3: return f(std::integral_constant<int, 3>());
+		case 4: return f(std::integral_constant<int, 4>());
+		default: return f(std::integral_constant<int, 0>());
+		}
+	}
+
+	// copy src into dst with its top-left corner at (y, x) and set every dst
+	// pixel outside that rectangle to black. src must fit inside dst. Only the
+	// border is cleared, so dst may be ImageInit::Uninitialized.
+	void embed(ConstImageView src, ImageView dst, int y, int x);
+
 }
 
@@ -0,0 +1,521 @@
+// Deferred op chains: fusion while the chain is built, tiled evaluation
+
+#include "lazy.h"
+#include "parallel.h"
+#include "rotate.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+using namespace imgproc;
+
+namespace
+{
+    // a band of one stage's output is about this big, so it (and the band
+    // of input it was made from) stays in L2 while the next stage reads it
+    constexpr size_t tileBytes = 256 * 1024;
+    constexpr int minTileRows = 8;
+
+    // a stage is tiled together with the ones after it while its bands,
+    // summed over all tiles, cover at most this many times its output
+    constexpr double maxRecompute = 2.0;
+
+    template <typename... Args>
+    std::string format(const char* fmt, Args... args)
+    {
+        char buf[96];
+        std::snprintf(buf, sizeof(buf), fmt, args...);
+        return buf;
+    }
+
+    Kernel convolve(const Kernel& a, const Kernel& b)
+    {
+        Kernel k(a.size() + b.size() - 1, 0.f);
+        for (size_t i = 0; i < a.size(); i++)
+            for (size_t j = 0; j < b.size(); j++)
+                k[i + j] += a[i] * b[j];
+        return k;
+    }
+
+    Interpolation interpolationOf(Scale::InterpolationMethod method)
+    {
+        return method == Scale::InterpolationMethod::NearestNeighbour
+            ? Interpolation::NearestNeighbour : Interpolation::Bilinear;
+    }
+
+    const char* interpolationName(Interpolation interpolation)
+    {
+        switch (interpolation)
+        {
+        case Interpolation::NearestNeighbour: return "nearest";
+        case Interpolation::Bilinear: return "bilinear";
+        case Interpolation::Bicubic: return "bicubic";
+        }
+        return "";
+    }
+
+    std::string joined(const std::vector<std::string>& ops)
+    {
+        std::string out;
+        for (const std::string& op : ops)
+            out += (out.empty() ? "" : " ") + op;
+        return out;
+    }
+
+    // Scale::resize only reads its input
+    Image borrow(ConstImageView v)
+    {
+        return Image(ImageView(const_cast<uint8_t*>(v.data), v.rows, v.cols, v.channels, v.stride));
+    }
+}
+
+LazyImage::LazyImage(const Image& img)
+: src(img.view())
+{
+}
+
+int LazyImage::rows() const
+{
+    return stages.empty() ? src.rows : stages.back().rows;
+}
+
+int LazyImage::cols() const
+{
+    return stages.empty() ? src.cols : stages.back().cols;
+}
+
+int LazyImage::inRows(int stage) const
+{
+    return stage == 0 ? src.rows : stages[stage - 1].rows;
+}
+
+LazyImage& LazyImage::scale(double factor, Scale::InterpolationMethod method)
+{
+    if (factor <= 0)
+        return *this;
+
+    return resize(std::max(1, static_cast<int>(std::lround(rows() * factor))),
+        std::max(1, static_cast<int>(std::lround(cols() * factor))), method);
+}
+
+LazyImage& LazyImage::resize(int newRows, int newCols, Scale::InterpolationMethod method)
+{
+    // Scale::resize gives an empty image; so does eval()
+    if (newRows <= 0 || newCols <= 0)
+    {
+        src = ConstImageView{};
+        stages.clear();
+        return *this;
+    }
+
+    const std::string op = format("resize(%dx%d)", newRows, newCols);
+
+    // area averaging along a shrinking axis is a box over a varying number
+    // of pixels, not a resampling, so it keeps its own kernel
+    if (method == Scale::InterpolationMethod::Area && (newRows < rows() || newCols < cols()))
+    {
+        Stage s{};
+        s.kind = Stage::Kind::Resize;
+        s.rows = newRows;
+        s.cols = newCols;
+        s.method = method;
+        s.ops = { op };
+        stages.push_back(std::move(s));
+        return *this;
+    }
+
+    // output pixel i is centred on source (i + 0.5) * srcLen / dstLen - 0.5,
+    // and edges replicate, as in Scale
+    const double sx = static_cast<double>(newCols) / cols();
+    const double sy = static_cast<double>(newRows) / rows();
+    const AffineMatrix m = AffineMatrix::translation(-0.5, -0.5) *
+        AffineMatrix::scaling(sx, sy) * AffineMatrix::translation(0.5, 0.5);
+    addGeometry(m, newRows, newCols, interpolationOf(method), true, op);
+    return *this;
+}
+
+LazyImage& LazyImage::rotate(double angle, Interpolation interpolation)
+{
+    int newRows = 0, newCols = 0;
+    const AffineMatrix m = Rotation::canvas(rows(), cols(), angle, newRows, newCols);
+    addGeometry(m, newRows, newCols, interpolation, false, format("rotate(%g)", angle));
+    return *this;
+}
+
+LazyImage& LazyImage::translate(int tx, int ty)
+{
+    const AffineMatrix m = AffineMatrix::translation(std::max(tx, 0), std::max(ty, 0));
+    addGeometry(m, rows() + std::abs(ty), cols() + std::abs(tx),
+        Interpolation::NearestNeighbour, false, format("translate(%d, %d)", tx, ty));
+    return *this;
+}
+
+void LazyImage::addGeometry(const AffineMatrix& m, int newRows, int newCols,
+    Interpolation interpolation, bool replicate, std::string op)
+{
+    // a point op in between stops the composition: it does not commute
+    // with interpolation
+    const bool compose = !stages.empty() && stages.back().kind == Stage::Kind::Warp
+        && stages.back().postOps.empty();
+    if (!compose)
+    {
+        Stage s{};
+        s.kind = Stage::Kind::Warp;
+        s.warp.interpolation = interpolation;
+        s.warp.border = replicate ? BorderMode::Replicate : BorderMode::Constant;
+        stages.push_back(std::move(s));
+    }
+
+    Stage& s = stages.back();
+    s.m = m * s.m;
+    s.rows = newRows;
+    s.cols = newCols;
+    s.warp.interpolation = std::max(s.warp.interpolation, interpolation);
+    // a rotation or translation needs its corners black; pure scales
+    // replicate their edges
+    if (!replicate)
+        s.warp.border = BorderMode::Constant;
+    s.ops.push_back(std::move(op));
+}
+
+LazyImage& LazyImage::brightness(int beta)
+{
+    addPoint(PointLut().brightness(beta), format("brightness(%d)", beta));
+    return *this;
+}
+
+LazyImage& LazyImage::contrast(float alpha)
+{
+    addPoint(PointLut().contrast(alpha), format("contrast(%g)", alpha));
+    return *this;
+}
+
+LazyImage& LazyImage::gamma(float g)
+{
+    addPoint(PointLut().gamma(g), format("gamma(%g)", g));
+    return *this;
+}
+
+LazyImage& LazyImage::invert()
+{
+    addPoint(PointLut().invert(), "invert");
+    return *this;
+}
+
+LazyImage& LazyImage::lut(const PointLut& table)
+{
+    addPoint(table, "lut");
+    return *this;
+}
+
+void LazyImage::addPoint(const PointLut& table, std::string op)
+{
+    // ops before anything else are a stage of their own, run band by band
+    // as the next stage reads the source
+    if (stages.empty())
+    {
+        Stage s{};
+        s.kind = Stage::Kind::Point;
+        s.rows = src.rows;
+        s.cols = src.cols;
+        stages.push_back(std::move(s));
+    }
+
+    Stage& s = stages.back();
+    s.post.then(table);
+    s.postOps.push_back(std::move(op));
+}
+
+LazyImage& LazyImage::gaussian(uint8_t kernelSize, float stdDev)
+{
+    if (kernelSize == 0)
+        kernelSize = gaussianKernelSize(stdDev);
+
+    const auto kernel = gaussianKernel(kernelSize, stdDev);
+    const std::string op = format("gaussian(%d, %g)", kernelSize, stdDev);
+
+    // two Gaussians in a row are one blur with the convolved kernel
+    if (!stages.empty() && stages.back().kind == Stage::Kind::Blur && stages.back().postOps.empty())
+    {
+        Stage& s = stages.back();
+        s.kernel = prepareKernel(convolve(s.kernel.weights, kernel->weights));
+        s.ops.push_back(op);
+        return *this;
+    }
+
+    Stage s{};
+    s.kind = Stage::Kind::Blur;
+    s.rows = rows();
+    s.cols = cols();
+    s.kernel = *kernel;
+    s.ops = { op };
+    stages.push_back(std::move(s));
+    return *this;
+}
+
+void LazyImage::footprint(int stage, int y0, int y1, int& a, int& b) const
+{
+    const Stage& s = stages[stage];
+    const int n = inRows(stage);
+
+    switch (s.kind)
+    {
+    case Stage::Kind::Point:
+        a = y0;
+        b = y1;
+        return;
+    case Stage::Kind::Resize:
+        a = 0;
+        b = n;
+        return;
+    case Stage::Kind::Blur:
+    {
+        const int r = static_cast<int>(s.kernel.weights.size() / 2);
+        a = std::max(0, y0 - r);
+        b = std::min(n, y1 + r);
+        return;
+    }
+    case Stage::Kind::Warp:
+    {
+        // the band's corners mapped back, widened by the bicubic support
+        const AffineMatrix inv = s.m.inverse();
+        double minY = 0, maxY = 0;
+        bool firstCorner = true;
+        for (const int y : { y0, y1 - 1 })
+            for (const int x : { 0, s.cols - 1 })
+            {
+                const double sy = inv.apply(x, y).y;
+                minY = firstCorner ? sy : std::min(minY, sy);
+                maxY = firstCorner ? sy : std::max(maxY, sy);
+                firstCorner = false;
+            }
+        // at least one row, so replicated taps always have theirs
+        a = std::clamp(static_cast<int>(std::floor(minY)) - 1, 0, n - 1);
+        b = std::clamp(static_cast<int>(std::floor(maxY)) + 3, a + 1, n);
+        return;
+    }
+    }
+}
+
+std::vector<LazyImage::Segment> LazyImage::segments() const
+{
+    const int n = static_cast<int>(stages.size());
+    const int channels = src.channels;
+
+    auto tileRowsOf = [&](int stage)
+    {
+        const size_t rowBytes = static_cast<size_t>(stages[stage].cols) * channels;
+        const int tile = static_cast<int>(tileBytes / std::max<size_t>(rowBytes, 1));
+        return std::clamp(tile, minTileRows, std::max(stages[stage].rows, 1));
+    };
+
+    // would tiling `last`'s output recompute any of first .. last - 1 more
+    // than maxRecompute times over?
+    auto tileable = [&](int first, int last)
+    {
+        const int tile = tileRowsOf(last);
+        std::vector<double> covered(last - first, 0.0);
+        for (int y0 = 0; y0 < stages[last].rows; y0 += tile)
+        {
+            int a = y0, b = std::min(y0 + tile, stages[last].rows);
+            for (int k = last; k > first; k--)
+            {
+                footprint(k, a, b, a, b);
+                covered[k - 1 - first] += b - a;
+            }
+        }
+        for (int k = first; k < last; k++)
+            if (covered[k - first] > maxRecompute * stages[k].rows)
+                return false;
+        return true;
+    };
+
+    std::vector<Segment> out;
+    for (int first = 0; first < n;)
+    {
+        int last = first;
+        if (stages[first].kind != Stage::Kind::Resize)
+            while (last + 1 < n && stages[last + 1].kind != Stage::Kind::Resize
+                && tileable(first, last + 1))
+                last++;
+
+        out.push_back({ first, last, stages[first].kind == Stage::Kind::Resize ? 0 : tileRowsOf(last) });
+        first = last + 1;
+    }
+    return out;
+}
+
+namespace
+{
+    const char* kindName(int kind)
+    {
+        static const char* const names[] = { "point", "warp", "resize", "blur" };
+        return names[kind];
+    }
+}
+
+std::string LazyImage::plan() const
+{
+    std::string out = format("source %dx%dx%d\n", src.rows, src.cols, src.channels);
+
+    for (size_t i = 0; i < stages.size(); i++)
+    {
+        const Stage& s = stages[i];
+        out += format("stage %zu: %s %dx%d", i, kindName(static_cast<int>(s.kind)), s.rows, s.cols);
+        if (s.kind == Stage::Kind::Warp)
+            out += std::string(" ") + interpolationName(s.warp.interpolation)
+                + (s.warp.border == BorderMode::Replicate ? " replicate" : " constant");
+        if (s.kind == Stage::Kind::Blur)
+            out += format(" %zu taps", s.kernel.weights.size());
+        if (!s.ops.empty())
+            out += "  [" + joined(s.ops) + "]";
+        if (!s.postOps.empty())
+            out += (s.ops.empty() ? "  lut [" : " then lut [") + joined(s.postOps) + "]";
+        out += "\n";
+    }
+
+    for (const Segment& seg : segments())
+    {
+        out += seg.first == seg.last
+            ? format("stage %d", seg.first)
+            : format("stages %d-%d", seg.first, seg.last);
+        out += seg.tileRows > 0 ? format(": bands of %d rows\n", seg.tileRows) : ": whole frame\n";
+    }
+    return out;
+}
+
+// one segment, evaluated band by band; produce() pulls each band's input
+// from the stage before it, down to the segment's materialized input
+struct LazyImage::Executor
+{
+    const LazyImage& lazy;
+    ConstImageView input;
+    int first;
+    std::vector<std::atomic<int64_t>>& ns;
+
+    using Clock = std::chrono::steady_clock;
+
+    void produce(int k, int y0, int y1, ImageView dst) const
+    {
+        const Stage& s = lazy.stages[k];
+
+        int a = y0, b = y1;
+        lazy.footprint(k, y0, y1, a, b);
+
+        Image scratch;
+        ConstImageView in;
+        if (k == first)
+            in = input.roi(a, 0, b - a, input.cols);
+        else
+        {
+            scratch = Image(b - a, lazy.stages[k - 1].cols, dst.channels, ImageInit::Uninitialized);
+            produce(k - 1, a, b, scratch.view());
+            in = scratch.view();
+        }
+
+        const Clock::time_point start = Clock::now();
+        switch (s.kind)
+        {
+        case Stage::Kind::Point:
+            s.post.apply(in, dst);
+            break;
+        case Stage::Kind::Warp:
+            detail::warpAffineRows(in, a, lazy.inRows(k), dst, y0, 0, s.m, s.warp);
+            break;
+        case Stage::Kind::Blur:
+            if (a == y0 && b == y1)
+                convolveSeparable(in, dst, s.kernel);
+            else
+            {
+                // rows outside [y0, y1) only feed the taps; the black
+                // border convolveSeparable assumes past them is never read
+                // for the rows kept, except where it really is the edge
+                Image band(b - a, in.cols, in.channels, ImageInit::Uninitialized);
+                convolveSeparable(in, band.view(), s.kernel);
+                for (int y = y0; y < y1; y++)
+                    std::memcpy(dst.row(y - y0), band.row(y - a), dst.rowElems());
+            }
+            break;
+        case Stage::Kind::Resize:
+            break; // whole frame; see eval()
+        }
+
+        if (s.kind != Stage::Kind::Point && !s.postOps.empty())
+            s.post.apply(dst, dst);
+
+        ns[k] += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+};
+
+Image LazyImage::eval(std::vector<StageTiming>* timings) const
+{
+    if (src.empty())
+        return Image{};
+
+    if (stages.empty())
+    {
+        Image copy(src.rows, src.cols, src.channels, ImageInit::Uninitialized);
+        for (int y = 0; y < src.rows; y++)
+            std::memcpy(copy.row(y), src.row(y), src.rowElems());
+        return copy;
+    }
+
+    std::vector<std::atomic<int64_t>> ns(stages.size());
+    for (std::atomic<int64_t>& t : ns)
+        t = 0;
+
+    // each segment's output is the next one's input
+    Image held;
+    ConstImageView input = src;
+    for (const Segment& seg : segments())
+    {
+        const Stage& last = stages[seg.last];
+
+        Image out;
+        if (last.kind == Stage::Kind::Resize)
+        {
+            const auto start = Executor::Clock::now();
+            out = Scale::resize(borrow(input), last.rows, last.cols, last.method);
+            if (!last.postOps.empty())
+                last.post.applyInPlace(out);
+            ns[seg.last] += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Executor::Clock::now() - start).count();
+        }
+        else
+        {
+            out = Image(last.rows, last.cols, src.channels, ImageInit::Uninitialized);
+            const Executor executor{ *this, input, seg.first, ns };
+            const int tiles = (last.rows + seg.tileRows - 1) / seg.tileRows;
+            ImageView dst = out.view();
+
+            parallelFor(0, tiles, [&](int tBegin, int tEnd)
+            {
+                for (int t = tBegin; t < tEnd; t++)
+                {
+                    const int y0 = t * seg.tileRows;
+                    const int y1 = std::min(y0 + seg.tileRows, last.rows);
+                    executor.produce(seg.last, y0, y1, dst.roi(y0, 0, y1 - y0, dst.cols));
+                }
+            });
+        }
+
+        held = std::move(out);
+        input = held.view();
+    }
+
+    if (timings)
+    {
+        timings->clear();
+        for (size_t i = 0; i < stages.size(); i++)
+            timings->push_back({ format("%zu %s", i, kindName(static_cast<int>(stages[i].kind))),
+                ns[i] / 1e6 });
+    }
+
+    return held;
+}
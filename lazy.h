@@ -0,0 +1,115 @@
+#pragma once
+
+#include "GaussianFilter.h"
+#include "imgOps.h"
+#include "pointLut.h"
+#include "scale.h"
+#include "warp.h"
+
+#include <string>
+#include <vector>
+
+namespace imgproc
+{
+    // Deferred chain of ops on one uint8 image. Nothing runs until eval();
+    // each call only records a node, fused into the previous one as it is
+    // added:
+    //   - point ops (brightness, contrast, gamma, invert, lut) fold into one
+    //     table applied as the previous stage writes its rows
+    //   - scale, resize, rotate and translate compose into one affine matrix
+    //     sampled once (warpAffine), at the best interpolation in the run
+    //   - back-to-back Gaussians convolve into one kernel
+    // eval() then produces the output in bands of rows sized to stay in
+    // cache, pulling just the source rows each band needs through every
+    // stage, so intermediates never exist as whole frames. A stage whose
+    // bands would recompute most of their input (a large rotation, a wide
+    // blur) gets that input materialized once instead.
+    //
+    //   Image out = LazyImage(img).brightness(20).contrast(1.2f)
+    //       .scale(1.5).rotate(30).gaussian(5, 1.4f).eval();
+    //
+    // Point ops and a single blur give exactly what the eager calls give;
+    // a fused pair of blurs skips the rounding to uint8 in between.
+    // Geometry is resampled once instead of once per op, so it differs from
+    // the eager chain by interpolation rounding (and rotate samples the
+    // canvas of Rotation::rotate through warpAffine, not its own kernels).
+    // Area downscales are not affine and run as their own whole-frame stage.
+    //
+    // The source is borrowed, not copied: it must outlive eval().
+    class LazyImage
+    {
+    public:
+        explicit LazyImage(const Image& img);
+
+        // same sizes and sampling as Scale::scale / Scale::resize
+        LazyImage& scale(double factor,
+            Scale::InterpolationMethod method = Scale::InterpolationMethod::Bilinear);
+        LazyImage& resize(int rows, int cols,
+            Scale::InterpolationMethod method = Scale::InterpolationMethod::Bilinear);
+        // canvas of Rotation::rotate; corners read black
+        LazyImage& rotate(double angle,
+            Interpolation interpolation = Interpolation::NearestNeighbour);
+        // canvas of translate(); uncovered pixels read black
+        LazyImage& translate(int tx, int ty);
+
+        LazyImage& brightness(int beta);
+        LazyImage& contrast(float alpha);
+        LazyImage& gamma(float g);
+        LazyImage& invert();
+        LazyImage& lut(const PointLut& table);
+
+        LazyImage& gaussian(uint8_t kernelSize, float stdDev);
+
+        int rows() const;
+        int cols() const;
+
+        struct StageTiming
+        {
+            std::string stage;
+            double ms; // summed over threads
+        };
+
+        // the fused stages, one per line, and how eval() will tile them
+        std::string plan() const;
+        // timings, if given, gets one entry per stage
+        Image eval(std::vector<StageTiming>* timings = nullptr) const;
+
+    private:
+        struct Stage
+        {
+            enum class Kind { Point, Warp, Resize, Blur };
+
+            Kind kind;
+            int rows, cols;            // output size
+            std::vector<std::string> ops; // the calls fused into it, for plan()
+
+            AffineMatrix m;            // Warp: input -> output
+            WarpOptions warp;
+            Scale::InterpolationMethod method{}; // Resize
+            PreparedKernel kernel;     // Blur
+
+            PointLut post;             // applied to every row written
+            std::vector<std::string> postOps;
+        };
+
+        // a run of stages evaluated band by band
+        struct Segment
+        {
+            int first, last;
+            int tileRows;
+        };
+
+        struct Executor;
+
+        ConstImageView src;
+        std::vector<Stage> stages;
+
+        int inRows(int stage) const;
+        void addGeometry(const AffineMatrix& m, int rows, int cols,
+            Interpolation interpolation, bool replicate, std::string op);
+        void addPoint(const PointLut& table, std::string op);
+        // input rows stage i reads for its output rows [y0, y1)
+        void footprint(int stage, int y0, int y1, int& a, int& b) const;
+        std::vector<Segment> segments() const;
+    };
+}
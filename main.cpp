@@ -4,6 +4,7 @@
 #include "similarity.h"
 #include "GaussianFilter.h"
 #include "enhancements.h"
+#include "cvInterop.h"
 
 #include <opencv2/core/mat.hpp>
 #include <opencv2/opencv.hpp>
@@ -95,7 +96,7 @@ int main()
     //cv::imshow("grayscale", grayImg);
 
 	// TODO: 
-	// - image pyramids (Laplacian), non-linear filters, template matching
+	// - non-linear filters, template matching
 	// - edge/corner detection
 	// 	- simple feature detector
 	// - stereo vision
@@ -0,0 +1,304 @@
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // a thread's share of bands, packed as (end << 32 | next) so the owner
+    // (popping from the front) and thieves (popping from the back) agree
+    // through a single compare-exchange
+    struct alignas(64) BandQueue
+    {
+        std::atomic<uint64_t> range{ 0 };
+
+        void reset(uint32_t first, uint32_t last)
+        {
+            range.store(static_cast<uint64_t>(last) << 32 | first, std::memory_order_relaxed);
+        }
+
+        bool popFront(uint32_t& band)
+        {
+            uint64_t r = range.load(std::memory_order_acquire);
+            for (;;)
+            {
+                const uint32_t next = static_cast<uint32_t>(r);
+                const uint32_t last = static_cast<uint32_t>(r >> 32);
+                if (next >= last)
+                    return false;
+                const uint64_t claimed = static_cast<uint64_t>(last) << 32 | (next + 1);
+                if (range.compare_exchange_weak(r, claimed, std::memory_order_acq_rel))
+                {
+                    band = next;
+                    return true;
+                }
+            }
+        }
+
+        bool popBack(uint32_t& band)
+        {
+            uint64_t r = range.load(std::memory_order_acquire);
+            for (;;)
+            {
+                const uint32_t next = static_cast<uint32_t>(r);
+                const uint32_t last = static_cast<uint32_t>(r >> 32);
+                if (next >= last)
+                    return false;
+                const uint64_t claimed = static_cast<uint64_t>(last - 1) << 32 | next;
+                if (range.compare_exchange_weak(r, claimed, std::memory_order_acq_rel))
+                {
+                    band = last - 1;
+                    return true;
+                }
+            }
+        }
+
+        uint32_t remaining() const
+        {
+            const uint64_t r = range.load(std::memory_order_relaxed);
+            const uint32_t next = static_cast<uint32_t>(r);
+            const uint32_t last = static_cast<uint32_t>(r >> 32);
+            return last > next ? last - next : 0;
+        }
+    };
+
+    struct Job
+    {
+        imgproc::detail::BandBody body{};
+        int begin = 0;
+        int end = 0;
+        int bandSize = 1;
+        std::vector<BandQueue> queues;
+
+        // the first exception a band threw; once set, the bands not yet
+        // started are skipped and run() rethrows it on the calling thread
+        std::mutex errorMutex;
+        std::exception_ptr error;
+        std::atomic<bool> failed{ false };
+    };
+
+    thread_local bool insideParallelRegion = false;
+
+    // marks this thread as running bands for as long as it lives, however
+    // the scope is left
+    struct ParallelRegion
+    {
+        const bool outer = insideParallelRegion;
+        ParallelRegion() { insideParallelRegion = true; }
+        ~ParallelRegion() { insideParallelRegion = outer; }
+    };
+
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(int nThreads)
+        : queueCount(std::max(1, nThreads))
+        {
+            job.queues = std::vector<BandQueue>(queueCount);
+            for (int i = 1; i < queueCount; i++)
+                workers.emplace_back([this, i] { workerLoop(i); });
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread& t : workers)
+                t.join();
+        }
+
+        int size() const { return queueCount; }
+
+        // returns false if the pool is already running a job
+        bool run(int begin, int end, int bandSize, imgproc::detail::BandBody body)
+        {
+            std::unique_lock<std::mutex> busy(runMutex, std::try_to_lock);
+            if (!busy.owns_lock())
+                return false;
+
+            const uint32_t bands = static_cast<uint32_t>((end - begin + bandSize - 1) / bandSize);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                job.body = body;
+                job.begin = begin;
+                job.end = end;
+                job.bandSize = bandSize;
+                job.error = nullptr;
+                job.failed.store(false, std::memory_order_relaxed);
+
+                // contiguous initial split keeps neighbouring rows on one thread
+                for (int q = 0; q < queueCount; q++)
+                    job.queues[q].reset(static_cast<uint32_t>(bands * uint64_t(q) / queueCount),
+                        static_cast<uint32_t>(bands * uint64_t(q + 1) / queueCount));
+
+                pending = queueCount - 1;
+                generation++;
+            }
+            wake.notify_all();
+
+            work(0);
+
+            // the workers may still be inside body, even after a throw
+            std::exception_ptr error;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                done.wait(lock, [this] { return pending == 0; });
+                job.body = {};
+                error = job.error;
+            }
+            if (error)
+                std::rethrow_exception(error);
+            return true;
+        }
+
+    private:
+        void workerLoop(int index)
+        {
+            uint64_t seen = 0;
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&] { return stopping || generation != seen; });
+                    if (stopping)
+                        return;
+                    seen = generation;
+                }
+
+                work(index);
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    pending--;
+                }
+                done.notify_one();
+            }
+        }
+
+        void runBand(uint32_t band)
+        {
+            if (job.failed.load(std::memory_order_relaxed))
+                return;
+
+            const int rowBegin = job.begin + static_cast<int>(band) * job.bandSize;
+            const int rowEnd = std::min(job.end, rowBegin + job.bandSize);
+            try
+            {
+                job.body(rowBegin, rowEnd);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(job.errorMutex);
+                if (!job.error)
+                    job.error = std::current_exception();
+                job.failed.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        void work(int index)
+        {
+            const ParallelRegion region;
+
+            uint32_t band;
+            while (job.queues[index].popFront(band))
+                runBand(band);
+
+            // own queue drained: steal from whoever has the most left
+            for (;;)
+            {
+                int victim = -1;
+                uint32_t most = 0;
+                for (int q = 0; q < queueCount; q++)
+                {
+                    const uint32_t left = job.queues[q].remaining();
+                    if (left > most)
+                    {
+                        most = left;
+                        victim = q;
+                    }
+                }
+                if (victim < 0)
+                    break;
+                if (job.queues[victim].popBack(band))
+                    runBand(band);
+            }
+        }
+
+        const int queueCount;
+        std::vector<std::thread> workers;
+        Job job;
+
+        std::mutex runMutex;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        uint64_t generation = 0;
+        int pending = 0;
+        bool stopping = false;
+    };
+
+    int defaultThreadCount()
+    {
+        const unsigned hw = std::thread::hardware_concurrency();
+        return hw == 0 ? 1 : static_cast<int>(hw);
+    }
+
+    std::mutex poolMutex;
+    std::shared_ptr<ThreadPool> poolInstance;
+    int requestedThreads = 0;
+
+    std::shared_ptr<ThreadPool> pool()
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        const int n = requestedThreads > 0 ? requestedThreads : defaultThreadCount();
+        if (!poolInstance || poolInstance->size() != n)
+            poolInstance = std::make_shared<ThreadPool>(n);
+        return poolInstance;
+    }
+}
+
+void imgproc::setNumThreads(int n)
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    requestedThreads = std::max(0, n);
+}
+
+int imgproc::getNumThreads()
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    return requestedThreads > 0 ? requestedThreads : defaultThreadCount();
+}
+
+void imgproc::detail::parallelFor(int begin, int end, BandBody body, int grain)
+{
+    if (end <= begin)
+        return;
+
+    const int n = end - begin;
+    grain = std::max(1, grain);
+
+    const int threads = insideParallelRegion ? 1 : getNumThreads();
+    if (threads == 1 || n <= grain)
+    {
+        body(begin, end);
+        return;
+    }
+
+    // several bands per thread so there is something left to steal
+    const int bandSize = std::max(grain, (n + threads * 8 - 1) / (threads * 8));
+
+    // keep the pool alive for the duration even if setNumThreads swaps it
+    std::shared_ptr<ThreadPool> p = pool();
+    if (!p->run(begin, end, bandSize, body))
+        body(begin, end);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+namespace imgproc
+{
+    // Threads parallelFor spreads work over, including the calling thread.
+    // Defaults to std::thread::hardware_concurrency(); n <= 0 restores that.
+    void setNumThreads(int n);
+    int getNumThreads();
+
+    namespace detail
+    {
+        // a borrowed reference to a parallelFor body; unlike a std::function
+        // it never copies the callable, so large captures cost no allocation
+        struct BandBody
+        {
+            const void* body;
+            void (*call)(const void* body, int rowBegin, int rowEnd);
+
+            void operator()(int rowBegin, int rowEnd) const { call(body, rowBegin, rowEnd); }
+        };
+
+        void parallelFor(int begin, int end, BandBody body, int grain);
+    }
+
+    // Runs body(rowBegin, rowEnd) over [begin, end) split into bands of at
+    // least `grain` rows. Each thread starts on its own contiguous run of
+    // bands and, once that is drained, steals bands from the back of the
+    // busiest-looking neighbour -- so uneven bands (e.g. rotated images that
+    // are mostly out of bounds) still balance.
+    // Calls made from inside a body, or while another parallelFor is
+    // running, execute serially on the calling thread.
+    // If a body throws, bands not yet started are skipped, every thread
+    // finishes the band it is on, and the first exception is rethrown here.
+    template <typename Body>
+    void parallelFor(int begin, int end, const Body& body, int grain = 1)
+    {
+        const detail::BandBody band{ &body, [](const void* b, int rowBegin, int rowEnd)
+        {
+            (*static_cast<const Body*>(b))(rowBegin, rowEnd);
+        } };
+        detail::parallelFor(begin, end, band, grain);
+    }
+}
@@ -0,0 +1,187 @@
+#include "pointLut.h"
+#include "cpuFeatures.h"
+#include "imgOps.h"
+#include "parallel.h"
+#include "pointLut_simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+imgproc::PointLut::PointLut()
+{
+    for (int i = 0; i < 256; i++)
+        lut[i] = static_cast<uint8_t>(i);
+}
+
+imgproc::PointLut& imgproc::PointLut::brightness(int beta)
+{
+    for (uint8_t& v : lut)
+        v = static_cast<uint8_t>(std::clamp(v + beta, 0, 255));
+    return *this;
+}
+
+imgproc::PointLut& imgproc::PointLut::contrast(float alpha)
+{
+    for (uint8_t& v : lut)
+        v = static_cast<uint8_t>(std::clamp(static_cast<int>(v * alpha), 0, 255));
+    return *this;
+}
+
+imgproc::PointLut& imgproc::PointLut::invert()
+{
+    for (uint8_t& v : lut)
+        v = static_cast<uint8_t>(255 - v);
+    return *this;
+}
+
+imgproc::PointLut& imgproc::PointLut::gamma(float g)
+{
+    // pow once per table entry rather than once per pixel
+    std::array<uint8_t, 256> mapped;
+    for (int i = 0; i < 256; i++)
+        mapped[i] = static_cast<uint8_t>(std::clamp(
+            std::lround(255.0 * std::pow(i / 255.0, static_cast<double>(g))), 0L, 255L));
+
+    for (uint8_t& v : lut)
+        v = mapped[v];
+    return *this;
+}
+
+imgproc::PointLut& imgproc::PointLut::curve(const std::vector<Point<int>>& points)
+{
+    if (points.empty())
+        return *this;
+
+    std::array<uint8_t, 256> mapped;
+    size_t seg = 0;
+    for (int i = 0; i < 256; i++)
+    {
+        while (seg + 1 < points.size() && points[seg + 1].x <= i)
+            seg++;
+
+        int out;
+        if (i <= points.front().x)
+            out = points.front().y;
+        else if (seg + 1 >= points.size())
+            out = points.back().y;
+        else
+        {
+            const Point<int>& a = points[seg];
+            const Point<int>& b = points[seg + 1];
+            out = static_cast<int>(std::lround(a.y + static_cast<double>(b.y - a.y) * (i - a.x) / (b.x - a.x)));
+        }
+        mapped[i] = static_cast<uint8_t>(std::clamp(out, 0, 255));
+    }
+
+    for (uint8_t& v : lut)
+        v = mapped[v];
+    return *this;
+}
+
+imgproc::PointLut& imgproc::PointLut::then(const PointLut& next)
+{
+    for (uint8_t& v : lut)
+        v = next.lut[v];
+    return *this;
+}
+
+bool imgproc::PointLut::isIdentity() const
+{
+    for (int i = 0; i < 256; i++)
+        if (lut[i] != i)
+            return false;
+    return true;
+}
+
+void imgproc::PointLut::apply(ConstImageView src, ImageView dst) const
+{
+    if (src.empty())
+        return;
+
+    const int rowElems = src.rowElems();
+    const bool identity = isIdentity();
+    const detail::LutRowFn rowFn = detail::selectLutRow();
+    parallelFor(0, src.rows, [&](int yBegin, int yEnd)
+    {
+        // a local copy: stores through dst may alias the table otherwise
+        const std::array<uint8_t, 256> t = lut;
+        for (int y = yBegin; y < yEnd; y++)
+        {
+            const uint8_t* s = src.row(y);
+            uint8_t* d = dst.row(y);
+            if (identity)
+            {
+                if (s != d)
+                    std::copy(s, s + rowElems, d);
+                continue;
+            }
+            rowFn(s, d, rowElems, t.data());
+        }
+    }, 16);
+}
+
+void imgproc::detail::lutRowScalar(const uint8_t* src, uint8_t* dst, int n,
+    const uint8_t* table)
+{
+    // unrolled to keep four independent lookups in flight
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const uint8_t a = table[src[i]];
+        const uint8_t b = table[src[i + 1]];
+        const uint8_t c = table[src[i + 2]];
+        const uint8_t e = table[src[i + 3]];
+        dst[i] = a;
+        dst[i + 1] = b;
+        dst[i + 2] = c;
+        dst[i + 3] = e;
+    }
+    for (; i < n; i++)
+        dst[i] = table[src[i]];
+}
+
+imgproc::detail::LutSteps imgproc::detail::lutSteps(const uint8_t* table)
+{
+    // step 0 holds the top sub-table of the half; step j the difference
+    // between sub-tables 7 - j and 8 - j (counted within the half)
+    LutSteps steps;
+    for (int half = 0; half < 2; half++)
+        for (int j = 0; j < 8; j++)
+        {
+            const uint8_t* sub = table + 16 * (8 * half + 7 - j);
+            for (int i = 0; i < 16; i++)
+                steps.diff[half][j][i] = j == 0 ? sub[i] : static_cast<uint8_t>(sub[i] ^ sub[i + 16]);
+        }
+    return steps;
+}
+
+imgproc::detail::LutRowFn imgproc::detail::selectLutRow()
+{
+    [[maybe_unused]] const SimdLevel level = simdLevel();
+#ifdef IMGPROC_HAVE_AVX2
+    if (level >= SimdLevel::AVX2)
+        return lutRowAVX2;
+#endif
+#ifdef IMGPROC_HAVE_SSE41
+    if (level >= SimdLevel::SSE41)
+        return lutRowSSE41;
+#endif
+    return lutRowScalar;
+}
+
+imgproc::Image imgproc::PointLut::apply(const Image& img) const
+{
+    if (img.empty())
+        return img;
+
+    Image out(img.rows, img.cols, img.channels, ImageInit::Uninitialized);
+    apply(img.view(), out.view());
+    return out;
+}
+
+void imgproc::PointLut::applyInPlace(Image& img) const
+{
+    if (isIdentity())
+        return;
+    apply(img.view(), img.view());
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "imgOps.h"
+
+#include <array>
+#include <vector>
+
+namespace imgproc
+{
+    // A uint8 point operation as a 256-entry table: out = table[in].
+    // Ops chain in call order and each one is folded into the table as it
+    // is added, so
+    //
+    //   PointLut().brightness(20).contrast(1.2f).gamma(0.8f).apply(img)
+    //
+    // touches the pixels once however long the chain is. Every step clamps
+    // to [0, 255], so the result is identical to running the ops one by one.
+    class PointLut
+    {
+    public:
+        PointLut(); // identity
+
+        PointLut& brightness(int beta);   // v + beta
+        PointLut& contrast(float alpha);  // v * alpha, truncated
+        PointLut& invert();               // 255 - v
+        // 255 * (v / 255)^g; g < 1 brightens the shadows, g > 1 darkens them
+        PointLut& gamma(float g);
+        // piecewise-linear through control points (in, out) with ascending
+        // x; inputs outside the first/last point take its output
+        PointLut& curve(const std::vector<Point<int>>& points);
+        // apply `next` after this table
+        PointLut& then(const PointLut& next);
+
+        uint8_t operator[](uint8_t v) const { return lut[v]; }
+        const std::array<uint8_t, 256>& table() const { return lut; }
+        bool isIdentity() const;
+
+        Image apply(const Image& img) const;
+        // src and dst must have the same size and channels; may be the same view
+        void apply(ConstImageView src, ImageView dst) const;
+        void applyInPlace(Image& img) const;
+
+    private:
+        std::array<uint8_t, 256> lut;
+    };
+}
@@ -0,0 +1,43 @@
+// Built with -mavx2; only called after cpuid reports AVX2.
+
+#include "pointLut_simd.h"
+
+#ifdef IMGPROC_HAVE_AVX2
+
+#include <immintrin.h>
+
+void imgproc::detail::lutRowAVX2(const uint8_t* src, uint8_t* dst, int n,
+    const uint8_t* table)
+{
+    // vpshufb looks up within 128-bit lanes, so each lane gets its own copy
+    // of every step's sub-table
+    const LutSteps steps = lutSteps(table);
+    __m256i diff[2][8];
+    for (int half = 0; half < 2; half++)
+        for (int j = 0; j < 8; j++)
+            diff[half][j] = _mm256_broadcastsi128_si256(
+                _mm_load_si128(reinterpret_cast<const __m128i*>(steps.diff[half][j])));
+
+    const __m256i topBit = _mm256_set1_epi8(static_cast<char>(0x80));
+    const __m256i step = _mm256_set1_epi8(16);
+
+    int i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i hi = _mm256_xor_si256(lo, topBit);
+        __m256i out = _mm256_xor_si256(_mm256_shuffle_epi8(diff[0][0], lo), _mm256_shuffle_epi8(diff[1][0], hi));
+        for (int j = 1; j < 8; j++)
+        {
+            lo = _mm256_adds_epu8(lo, step);
+            hi = _mm256_adds_epu8(hi, step);
+            out = _mm256_xor_si256(out, _mm256_xor_si256(
+                _mm256_shuffle_epi8(diff[0][j], lo), _mm256_shuffle_epi8(diff[1][j], hi)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), out);
+    }
+
+    lutRowScalar(src + i, dst + i, n - i, table);
+}
+
+#endif
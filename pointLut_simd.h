@@ -0,0 +1,42 @@
+#pragma once
+
+// Row kernel behind PointLut::apply, one per instruction set. Internal to
+// pointLut -- not part of the public imgproc API.
+
+#include <cstdint>
+
+namespace imgproc::detail
+{
+    // dst[i] = table[src[i]]   for i in [0, n); src and dst may be the same row
+    using LutRowFn = void (*)(const uint8_t* src, uint8_t* dst, int n,
+        const uint8_t* table);
+
+    // best kernel that was compiled in and is allowed by simdLevel()
+    LutRowFn selectLutRow();
+
+    void lutRowScalar(const uint8_t* src, uint8_t* dst, int n, const uint8_t* table);
+
+    // There is no byte gather, so the vector kernels split the table into
+    // 16 sub-tables of 16 entries and look up the low nibble in each with
+    // pshufb, which zeroes bytes whose index has bit 7 set. Adding 16 with
+    // unsigned saturation per step walks each byte's index up until it sets
+    // bit 7, so a byte whose high nibble is h takes part in the steps up to
+    // its own half's h; XORing in each sub-table's difference from the one
+    // above it leaves exactly table[v]. Pure selection, so every variant is
+    // bit-identical to the scalar path.
+    struct LutSteps
+    {
+        // [half][step]: step j of the low (v < 128) or high half
+        alignas(16) uint8_t diff[2][8][16];
+    };
+
+    LutSteps lutSteps(const uint8_t* table);
+
+#ifdef IMGPROC_HAVE_SSE41
+    void lutRowSSE41(const uint8_t* src, uint8_t* dst, int n, const uint8_t* table);
+#endif
+
+#ifdef IMGPROC_HAVE_AVX2
+    void lutRowAVX2(const uint8_t* src, uint8_t* dst, int n, const uint8_t* table);
+#endif
+}
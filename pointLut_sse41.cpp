@@ -0,0 +1,42 @@
+// Built with -msse4.1; only called after cpuid reports SSE4.1.
+
+#include "pointLut_simd.h"
+
+#ifdef IMGPROC_HAVE_SSE41
+
+#include <smmintrin.h>
+
+void imgproc::detail::lutRowSSE41(const uint8_t* src, uint8_t* dst, int n,
+    const uint8_t* table)
+{
+    const LutSteps steps = lutSteps(table);
+    __m128i diff[2][8];
+    for (int half = 0; half < 2; half++)
+        for (int j = 0; j < 8; j++)
+            diff[half][j] = _mm_load_si128(reinterpret_cast<const __m128i*>(steps.diff[half][j]));
+
+    const __m128i topBit = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128i step = _mm_set1_epi8(16);
+
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        // the high half indexes with bit 7 flipped, so the low half's
+        // bytes start out zeroed there and vice versa
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i hi = _mm_xor_si128(lo, topBit);
+        __m128i out = _mm_xor_si128(_mm_shuffle_epi8(diff[0][0], lo), _mm_shuffle_epi8(diff[1][0], hi));
+        for (int j = 1; j < 8; j++)
+        {
+            lo = _mm_adds_epu8(lo, step);
+            hi = _mm_adds_epu8(hi, step);
+            out = _mm_xor_si128(out, _mm_xor_si128(
+                _mm_shuffle_epi8(diff[0][j], lo), _mm_shuffle_epi8(diff[1][j], hi)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), out);
+    }
+
+    lutRowScalar(src + i, dst + i, n - i, table);
+}
+
+#endif
@@ -1,16 +1,47 @@
 #include "rotate.h"
 #include "imgOps.h"
+#include "parallel.h"
+#include "warp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 
 using namespace imgproc;
 
 Image Rotation::rotate(
 	const Image& oImg,
 	double angle,
-	const rotateMethod method)
+	const rotateMethod method,
+	const Interpolation interpolation)
 {
+	int newWidth = 0, newHeight = 0;
+	canvas(oImg.rows, oImg.cols, angle, newHeight, newWidth);
+
+	// CCW in LL system is CW in UL system
+	const double angleRad = -angle / 180.0 * PI;
+
+	// create black image
+	// (inverse mapping clears everything outside the source span itself)
+    Image rotatedImg(newHeight, newWidth, oImg.channels,
+		method == rotateMethod::INV_MAP ? ImageInit::Uninitialized : ImageInit::Zero);
+
+	// 2 approaches: forward and inverse mapping
+	if (method == rotateMethod::FWD_MAP)
+		rotateFwd(oImg, rotatedImg, angleRad);
 
-	int originalImgWidth = oImg.cols;
-	int originalImgHeight = oImg.rows;
+	else if (method == rotateMethod::INV_MAP)
+		rotateInv(oImg, rotatedImg, angleRad, interpolation);
+
+	return rotatedImg;
+}
+
+AffineMatrix Rotation::canvas(int rows, int cols, double angle,
+	int& outRows, int& outCols)
+{
+	int originalImgWidth = cols;
+	int originalImgHeight = rows;
 
 	// CCW in LL system is CW in UL system
 	angle *= -1;
@@ -38,26 +69,20 @@ Image Rotation::rotate(
 	// rotate each original, translated corner to get new corner
 	Point<int> rotatedUL{}, rotatedUR{}, rotatedLL{}, rotatedLR{};
 	double angleRad = angle / 180.0 * PI;
+	const double cosA = std::cos(angleRad);
+	const double sinA = std::sin(angleRad);
 
-	rotatedLR.x = static_cast<int>
-		(std::round(std::cos(angleRad) * originalLR.x - std::sin(angleRad) * originalLR.y));
-	rotatedLR.y = static_cast<int>
-		(std::round(std::sin(angleRad) * originalLR.x + std::cos(angleRad) * originalLR.y));
-
-	rotatedUR.x = static_cast<int>
-		(std::round(std::cos(angleRad) * originalUR.x - std::sin(angleRad) * originalUR.y));
-	rotatedUR.y = static_cast<int>
-		(std::round(std::sin(angleRad) * originalUR.x + std::cos(angleRad) * originalUR.y));
-
-	rotatedUL.x = static_cast<int>
-		(std::round(std::cos(angleRad) * originalUL.x - std::sin(angleRad) * originalUL.y));
-	rotatedUL.y = static_cast<int>
-		(std::round(std::sin(angleRad) * originalUL.x + std::cos(angleRad) * originalUL.y));
+	auto rotateCorner = [&](const Point<int>& p)
+	{
+		return Point<int>(
+			static_cast<int>(std::round(cosA * p.x - sinA * p.y)),
+			static_cast<int>(std::round(sinA * p.x + cosA * p.y)));
+	};
 
-	rotatedLL.x = static_cast<int>
-		(std::round(std::cos(angleRad) * originalLL.x - std::sin(angleRad) * originalLL.y));
-	rotatedLL.y = static_cast<int>
-		(std::round(std::sin(angleRad) * originalLL.x + std::cos(angleRad) * originalLL.y));
+	rotatedLR = rotateCorner(originalLR);
+	rotatedUR = rotateCorner(originalUR);
+	rotatedUL = rotateCorner(originalUL);
+	rotatedLL = rotateCorner(originalLL);
 
 	// translate rotated coords back from center in original coordinate space
 	rotatedUL.x += originalImgWidth / 2;
@@ -76,82 +101,272 @@ Image Rotation::rotate(
 	auto [minX, maxX] = std::minmax( { rotatedUL.x, rotatedUR.x, rotatedLL.x, rotatedLR.x } );
 	auto [minY, maxY] = std::minmax( { rotatedUL.y, rotatedUR.y, rotatedLL.y, rotatedLR.y } );
 
-	int newWidth = maxX - minX;
-	int newHeight = maxY - minY;
+	outCols = maxX - minX;
+	outRows = maxY - minY;
 
-	// create black image
-    Image rotatedImg(newHeight, newWidth, oImg.channels);
+	// the centre of the canvas maps to the centre of the source
+	return (AffineMatrix::translation(originalImgWidth / 2, originalImgHeight / 2) *
+		AffineMatrix::rotation(angle) *
+		AffineMatrix::translation(-(outCols / 2), -(outRows / 2))).inverse();
+}
 
-	// 2 approaches: forward and inverse mapping
-	if (method == rotateMethod::FWD_MAP)
-		rotateFwd(oImg, rotatedImg, angleRad);
+namespace
+{
+	// Coordinates are stepped along a row in 32.32 fixed point: one add per
+	// pixel instead of a sin/cos/round per pixel, and exact, so the span of
+	// valid pixels can be solved for once per row.
+	constexpr int fracBits = 32;
+	constexpr int64_t one = int64_t(1) << fracBits;
 
-	else if (method == rotateMethod::INV_MAP)
-		rotateInv(oImg, rotatedImg, angleRad);
+	int64_t toFixed(double v)
+	{
+		return static_cast<int64_t>(std::llround(v * static_cast<double>(one)));
+	}
 
-	return rotatedImg;
+	// floor(a / b) for b > 0
+	int64_t floorDiv(int64_t a, int64_t b)
+	{
+		return a >= 0 ? a / b : -((-a + b - 1) / b);
+	}
+
+	struct Span
+	{
+		int begin = 0;
+		int end = 0;
+	};
+
+	// narrow span to the steps i for which lo <= start + i * step < hi
+	Span clip(Span span, int64_t start, int64_t step, int64_t lo, int64_t hi)
+	{
+		int64_t first, last;
+		if (step > 0)
+		{
+			first = floorDiv(lo - start + step - 1, step);
+			last = floorDiv(hi - start + step - 1, step);
+		}
+		else if (step < 0)
+		{
+			first = floorDiv(start - hi, -step) + 1;
+			last = floorDiv(start - lo, -step) + 1;
+		}
+		else
+		{
+			const bool inside = start >= lo && start < hi;
+			first = inside ? span.begin : 0;
+			last = inside ? span.end : 0;
+		}
+
+		span.begin = static_cast<int>(std::max<int64_t>(span.begin, first));
+		span.end = static_cast<int>(std::min<int64_t>(span.end, last));
+		if (span.end < span.begin)
+			span.end = span.begin;
+		return span;
+	}
 }
 
 void Rotation::rotateFwd(const Image& oImg, Image& rImg,
 			double angle)
 {
-	for (int y = 0; y < oImg.rows; y++)
+	// stays single-threaded: different source pixels can land on the same
+	// destination pixel, so source-row bands would race on their writes
+	ImageView dst = rImg.view();
+
+	const double cosA = std::cos(angle);
+	const double sinA = std::sin(angle);
+
+	// moving one pixel right in the source moves (cos, sin) in the rotated image
+	const int64_t dx = toFixed(cosA);
+	const int64_t dy = toFixed(sinA);
+	const int64_t maxX = static_cast<int64_t>(rImg.cols) << fracBits;
+	const int64_t maxY = static_cast<int64_t>(rImg.rows) << fracBits;
+
+	withChannels(oImg.channels, [&](auto count)
 	{
-		for (int x = 0; x < oImg.cols; x++)
+		constexpr int C = decltype(count)::value;
+		const int channels = C != 0 ? C : oImg.channels;
+
+		for (int y = 0; y < oImg.rows; y++)
 		{
-			// translate original coords to center
-			int centeredX = x - oImg.cols / 2;
-			int centeredY = y - oImg.rows / 2;
-
-			// rotate
-			// nearest neighbour interpolation
-			int newX = static_cast<int>
-				(std::round(std::cos(angle) * centeredX - std::sin(angle) * centeredY));
-			int newY = static_cast<int>
-				(std::round(std::sin(angle) * centeredX + std::cos(angle) * centeredY));
-
-			// translate rotated coords back from center in rotated coord space
-			newX += rImg.cols / 2;
-			newY += rImg.rows / 2;
-
-			// validity check
-			if (newY < 0 || newX < 0 || newY >= rImg.rows || newX >= rImg.cols)
-				continue;
-
-			// dump color to rotated image pixel position
-            rImg.setPixel(newY, newX, oImg.getPixel(y, x));
+			// translate original coords to center, rotate, translate back
+			// to center in rotated coord space. nearest neighbour rounding is
+			// folded in (+0.5) so the integer part is the pixel
+			const int centeredY = y - oImg.rows / 2;
+			const int centeredX0 = -(oImg.cols / 2);
+			int64_t newX = toFixed(cosA * centeredX0 - sinA * centeredY + rImg.cols / 2 + 0.5);
+			int64_t newY = toFixed(sinA * centeredX0 + cosA * centeredY + rImg.rows / 2 + 0.5);
+
+			// validity check, solved once for the whole row
+			Span span{ 0, oImg.cols };
+			span = clip(span, newX, dx, 0, maxX);
+			span = clip(span, newY, dy, 0, maxY);
+
+			newX += span.begin * dx;
+			newY += span.begin * dy;
+
+			const uint8_t* src = oImg.row(y);
+			for (int x = span.begin; x < span.end; x++, newX += dx, newY += dy)
+			{
+				// dump color to rotated image pixel position
+				uint8_t* out = dst.row(static_cast<int>(newY >> fracBits))
+					+ static_cast<int>(newX >> fracBits) * channels;
+				for (int c = 0; c < channels; c++)
+					out[c] = src[x * channels + c];
+			}
 		}
-	}
+	});
 }
 
-void Rotation::rotateInv(const Image& oImg, Image& rImg, double angle)
+void Rotation::rotateInv(const Image& oImg, Image& rImg, double angle,
+	Interpolation interpolation)
 {
-	for (int yPrime = 0; yPrime < rImg.rows; yPrime++)
+	if (interpolation == Interpolation::Bicubic)
 	{
-		for (int xPrime = 0; xPrime < rImg.cols; xPrime++)
-		{
-			// apply inverse rotation to each rotated pixel position to get original pixel position
-			// round new fp position to the closest int
+		// same geometry through the general warp: the centre of rImg maps to
+		// the centre of oImg, rotated back by the inverse map
+		const AffineMatrix toSource =
+			AffineMatrix::translation(oImg.cols / 2, oImg.rows / 2) *
+			AffineMatrix::rotation(angle / PI * 180.0) *
+			AffineMatrix::translation(-(rImg.cols / 2), -(rImg.rows / 2));
+
+		WarpOptions options;
+		options.interpolation = interpolation;
+		options.rows = rImg.rows;
+		options.cols = rImg.cols;
+		rImg = warpAffine(oImg, toSource.inverse(), options);
+		return;
+	}
 
-			// translate rotated coordinates to center in rotated coord space
-			const int xCentered = xPrime - rImg.cols / 2;
-			const int yCentered = yPrime - rImg.rows / 2;
+	ConstImageView src = oImg.view();
+	const bool bilinear = interpolation == Interpolation::Bilinear;
 
-			int x = static_cast<int>
-				(std::round(std::cos(angle) * xCentered + std::sin(angle) * yCentered));
-			int y = static_cast<int>
-				(std::round(-1 * std::sin(angle) * xCentered + std::cos(angle) * yCentered));
+	// apply inverse rotation to each rotated pixel position to get original pixel position
+	//   x =  cos * xCentered + sin * yCentered
+	//   y = -sin * xCentered + cos * yCentered
+	// both are linear in xPrime, so walk them with one add per pixel
+	const double cosA = std::cos(angle);
+	const double sinA = std::sin(angle);
+	const int64_t dx = toFixed(cosA);
+	const int64_t dy = toFixed(-sinA);
 
-			// translate rotated coords back to center in original coord space
-			y += oImg.rows / 2;
-			x += oImg.cols / 2;
+	// nearest rounds by adding 0.5 up front; bilinear keeps the true position
+	const double bias = bilinear ? 0.0 : 0.5;
 
-			// validity check
-			if (y < 0 || x < 0 || y >= oImg.rows || x >= oImg.cols)
-				continue;
+	const int64_t srcW = static_cast<int64_t>(oImg.cols) << fracBits;
+	const int64_t srcH = static_cast<int64_t>(oImg.rows) << fracBits;
 
-			// dump color to rotated image pixel position
-			rImg.setPixel(yPrime, xPrime, oImg.getPixel(y, x));
-		}
-	}
+	// channel loops are unrolled for 1, 3 and 4 channels
+	withChannels(oImg.channels, [&](auto count)
+	{
+		constexpr int C = decltype(count)::value;
+		const int channels = C != 0 ? C : oImg.channels;
+
+		// most of the canvas corners map outside the source, so bands are uneven
+		parallelFor(0, rImg.rows, [&](int yBegin, int yEnd)
+		{
+			for (int yPrime = yBegin; yPrime < yEnd; yPrime++)
+			{
+				// translate rotated coordinates to center in rotated coord space,
+				// rotate back, translate to center in original coord space
+				const int xCentered0 = -(rImg.cols / 2);
+				const int yCentered = yPrime - rImg.rows / 2;
+				const int64_t rowX = toFixed(cosA * xCentered0 + sinA * yCentered + oImg.cols / 2 + bias);
+				const int64_t rowY = toFixed(-sinA * xCentered0 + cosA * yCentered + oImg.rows / 2 + bias);
+
+				// validity check, solved once for the whole row:
+				// outer = columns whose sample touches the source at all,
+				// inner = columns whose every tap is inside (no checks needed)
+				const Span all{ 0, rImg.cols };
+				Span outer, inner;
+				if (bilinear)
+				{
+					outer = clip(clip(all, rowX, dx, -one + 1, srcW), rowY, dy, -one + 1, srcH);
+					inner = clip(clip(outer, rowX, dx, 0, srcW - one), rowY, dy, 0, srcH - one);
+					if (inner.begin >= inner.end)
+						inner = Span{ outer.end, outer.end };
+				}
+				else
+				{
+					outer = clip(clip(all, rowX, dx, 0, srcW), rowY, dy, 0, srcH);
+					inner = outer;
+				}
+
+				// everything outside the source is black
+				uint8_t* dst = rImg.row(yPrime);
+				std::memset(dst, 0, static_cast<size_t>(outer.begin) * channels);
+				std::memset(dst + outer.end * channels, 0,
+					static_cast<size_t>(rImg.cols - outer.end) * channels);
+
+				if (!bilinear)
+				{
+					int64_t x = rowX + inner.begin * dx;
+					int64_t y = rowY + inner.begin * dy;
+					for (int xPrime = inner.begin; xPrime < inner.end; xPrime++, x += dx, y += dy)
+					{
+						// dump color to rotated image pixel position
+						const uint8_t* in = src.row(static_cast<int>(y >> fracBits))
+							+ static_cast<int>(x >> fracBits) * channels;
+						for (int c = 0; c < channels; c++)
+							dst[xPrime * channels + c] = in[c];
+					}
+					continue;
+				}
+
+				// bilinear with 8-bit weights; on the fringe, taps outside the
+				// source read black
+				auto sample = [&](int xPrime)
+				{
+					const int64_t x = rowX + xPrime * dx;
+					const int64_t y = rowY + xPrime * dy;
+					const int x0 = static_cast<int>(x >> fracBits);
+					const int y0 = static_cast<int>(y >> fracBits);
+					const int a = static_cast<int>((x >> (fracBits - 8)) & 255);
+					const int b = static_cast<int>((y >> (fracBits - 8)) & 255);
+
+					const uint8_t* taps[4];
+					for (int t = 0; t < 4; t++)
+					{
+						const int ty = y0 + (t >> 1);
+						const int tx = x0 + (t & 1);
+						const bool valid = ty >= 0 && tx >= 0 && ty < oImg.rows && tx < oImg.cols;
+						taps[t] = valid ? src.row(ty) + tx * channels : nullptr;
+					}
+
+					// pixel = (1 - a)(1 - b)P00 + a(1 - b)P01 + (1 - a)bP10 + abP11
+					for (int c = 0; c < channels; c++)
+					{
+						const int p00 = taps[0] ? taps[0][c] : 0;
+						const int p01 = taps[1] ? taps[1][c] : 0;
+						const int p10 = taps[2] ? taps[2][c] : 0;
+						const int p11 = taps[3] ? taps[3][c] : 0;
+						const int top = p00 * (256 - a) + p01 * a;
+						const int bottom = p10 * (256 - a) + p11 * a;
+						dst[xPrime * channels + c] =
+							static_cast<uint8_t>((top * (256 - b) + bottom * b + (1 << 15)) >> 16);
+					}
+				};
+
+				for (int xPrime = outer.begin; xPrime < inner.begin; xPrime++)
+					sample(xPrime);
+				int64_t x = rowX + inner.begin * dx;
+				int64_t y = rowY + inner.begin * dy;
+				for (int xPrime = inner.begin; xPrime < inner.end; xPrime++, x += dx, y += dy)
+				{
+					const int a = static_cast<int>((x >> (fracBits - 8)) & 255);
+					const int b = static_cast<int>((y >> (fracBits - 8)) & 255);
+					const uint8_t* top = src.row(static_cast<int>(y >> fracBits))
+						+ static_cast<int>(x >> fracBits) * channels;
+					const uint8_t* bottom = top + src.stride;
+					for (int c = 0; c < channels; c++)
+					{
+						const int t = top[c] * (256 - a) + top[c + channels] * a;
+						const int u = bottom[c] * (256 - a) + bottom[c + channels] * a;
+						dst[xPrime * channels + c] =
+							static_cast<uint8_t>((t * (256 - b) + u * b + (1 << 15)) >> 16);
+					}
+				}
+				for (int xPrime = inner.end; xPrime < outer.end; xPrime++)
+					sample(xPrime);
+			}
+		}, 4);
+	});
 }
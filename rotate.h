@@ -1,22 +1,30 @@
 #pragma once
 
 #include "imgOps.h"
+#include "warp.h"
 
 namespace imgproc
 {
-    static constexpr double PI = 3.14159;
-
     class Rotation
     {
     public:
         enum class rotateMethod { FWD_MAP, INV_MAP };
+
+        // interpolation applies to INV_MAP; FWD_MAP always scatters whole pixels
         static Image rotate(const Image& oImg, double angle,
-            rotateMethod method);
+            rotateMethod method,
+            Interpolation interpolation = Interpolation::NearestNeighbour);
+
+        // size of the canvas rotate() makes for a rows x cols image, and the
+        // map from source to canvas coordinates its inverse mapping samples
+        static AffineMatrix canvas(int rows, int cols, double angle,
+            int& outRows, int& outCols);
 
     private:
         static void rotateFwd(const Image& oImg, Image& rImg,
             double angle);
-        static void rotateInv(const Image& oImg, Image& rImg, double angle);
+        static void rotateInv(const Image& oImg, Image& rImg, double angle,
+            Interpolation interpolation);
 
     };
-}
\ No newline at end of file
+}
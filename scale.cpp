@@ -1,107 +1,233 @@
 #include "scale.h"
 #include "imgOps.h"
+#include "parallel.h"
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 using namespace imgproc;
 
-Image Scale::nearestNeighbour(const Image& img, const uint8_t scale)
+namespace
 {
-	// for each integer position in new image, find its fp equivalent in original image
-	// round to nearest integer position.
-	Image sImg(img.rows * scale, img.cols * scale, img.channels);
+	// Precomputed 1-D resampling along one axis: output i reads `taps` source
+	// indices index[i * taps + k] with weights weight[i * taps + k]. Built once
+	// per axis and reused for every row/column instead of recomputing
+	// floor/ceil and weights per output pixel.
+	struct FilterTable
+	{
+		int taps = 0;
+		std::vector<int> index;
+		std::vector<float> weight;
+
+		FilterTable(int count, int _taps)
+		: taps(_taps), index(static_cast<size_t>(count) * _taps, 0),
+		  weight(static_cast<size_t>(count) * _taps, 0.f) {}
+	};
+
+	// each table covers outputs [first, first + count) of dstLen, so a tile
+	// only builds the entries it reads
+
+	// output pixel i is centred on source position (i + 0.5) * srcLen / dstLen - 0.5
+	double sourceCentre(int i, int srcLen, int dstLen)
+	{
+		return (i + 0.5) * srcLen / dstLen - 0.5;
+	}
 
-	for (int i = 0; i < sImg.rows * sImg.cols * sImg.channels; i += sImg.channels)
+	FilterTable nearestTable(int srcLen, int dstLen, int first, int count)
 	{
-		auto sImgPt = Point<int>((i % sImg.cols), (i / sImg.cols));
-        // Find corresponding position in the original image (source pixel)
-		int nearestOrigX = std::round(sImgPt.x / scale);
-		int nearestOrigY = std::round(sImgPt.y / scale);
+		FilterTable t(count, 1);
+		for (int j = 0; j < count; j++)
+		{
+			// for integer upscales this is exactly i / scale
+			const int i = first + j;
+			const int nearest = static_cast<int>(std::floor((i + 0.5) * srcLen / dstLen));
+			t.index[j] = std::min(nearest, srcLen - 1);
+			t.weight[j] = 1.f;
+		}
+		return t;
+	}
 
-		// Ensure within bounds
-		if (nearestOrigX < 0 || nearestOrigX >= img.cols || nearestOrigY < 0 || nearestOrigY >= img.rows)
-			continue;
+	FilterTable bilinearTable(int srcLen, int dstLen, int first, int count)
+	{
+		// linear interpolation between the two neighbours; edges replicate
+		FilterTable t(count, 2);
+		for (int j = 0; j < count; j++)
+		{
+			const double pos = sourceCentre(first + j, srcLen, dstLen);
+			const int left = static_cast<int>(std::floor(pos));
+			const float frac = static_cast<float>(pos - left);
+
+			t.index[j * 2] = std::clamp(left, 0, srcLen - 1);
+			t.index[j * 2 + 1] = std::clamp(left + 1, 0, srcLen - 1);
+			t.weight[j * 2] = 1.f - frac;
+			t.weight[j * 2 + 1] = frac;
+		}
+		return t;
+	}
 
-		// Copy pixel data from original image to scaled image
-		sImg.setPixel(sImgPt.y, sImgPt.x, img.getPixel(nearestOrigY, nearestOrigX));
+	FilterTable areaTable(int srcLen, int dstLen, int first, int count)
+	{
+		// output i covers source [i * ratio, (i + 1) * ratio); each source
+		// pixel contributes the length of its overlap
+		const double ratio = static_cast<double>(srcLen) / dstLen;
+		const int taps = static_cast<int>(std::ceil(ratio)) + 1;
+
+		FilterTable t(count, taps);
+		for (int o = 0; o < count; o++)
+		{
+			const int i = first + o;
+			const double start = i * ratio;
+			const double end = std::min((i + 1) * ratio, static_cast<double>(srcLen));
+			int k = 0;
+			for (int j = static_cast<int>(std::floor(start)); j < end && k < taps; j++)
+			{
+				const double overlap = std::min(end, j + 1.0) - std::max(start, static_cast<double>(j));
+				if (overlap <= 0)
+					continue;
+				t.index[o * taps + k] = j;
+				t.weight[o * taps + k] = static_cast<float>(overlap / ratio);
+				k++;
+			}
+			// unused taps repeat the last source pixel with weight 0, so
+			// every index stays inside the span this output actually reads
+			for (; k < taps; k++)
+				t.index[o * taps + k] = t.index[o * taps + k - 1];
+		}
+		return t;
 	}
-	
-	return sImg;
 }
 
-Image Scale::bilinear(const Image& img, const uint8_t scale)
+void Scale::nearestNeighbour(ConstImageView img, ImageView sImg,
+	const int rows, const int cols, const int y0, const int x0)
 {
-	// linear interpolation
 	// for each integer position in new image, find its fp equivalent in original image
-	// get 4 integer neighbourhood pixels -- UL, UR, LL, LR
-	// dx = fp.X - xPos; dy = fp.Y - yPos
-	// interpolate in x:  L-R (top and bottom)
-	// interpolate in y:  T-B (final)
+	// round to nearest integer position -- looked up from the tables
+	const FilterTable rowTable = nearestTable(img.rows, rows, y0, sImg.rows);
+	const FilterTable colTable = nearestTable(img.cols, cols, x0, sImg.cols);
 
-	Image sImg(img.rows * scale, img.cols * scale, img.channels);
+	withChannels(img.channels, [&](auto count)
+	{
+		constexpr int C = decltype(count)::value;
+		const int channels = C != 0 ? C : img.channels;
+
+		parallelFor(0, sImg.rows, [&](int yBegin, int yEnd)
+		{
+			for (int y = yBegin; y < yEnd; y++)
+			{
+				const uint8_t* src = img.row(rowTable.index[y]);
+				uint8_t* dst = sImg.row(y);
+				for (int x = 0; x < sImg.cols; x++)
+				{
+					const uint8_t* nearest = src + colTable.index[x] * channels;
+					for (int c = 0; c < channels; c++)
+						dst[x * channels + c] = nearest[c];
+				}
+			}
+		}, 16);
+	});
+}
 
-	for (int i = 0; i < sImg.rows * sImg.cols * sImg.channels; i += sImg.channels)
+void Scale::separable(ConstImageView img, ImageView sImg,
+	const int rows, const int cols, const int y0, const int x0,
+	const InterpolationMethod intMethod)
+{
+	// filter columns (vertical taps over whole source rows) into a float
+	// line, then filter that line horizontally into the output row
+	const bool area = intMethod == InterpolationMethod::Area;
+	const FilterTable rowTable = (area && rows < img.rows)
+		? areaTable(img.rows, rows, y0, sImg.rows) : bilinearTable(img.rows, rows, y0, sImg.rows);
+	FilterTable colTable = (area && cols < img.cols)
+		? areaTable(img.cols, cols, x0, sImg.cols) : bilinearTable(img.cols, cols, x0, sImg.cols);
+
+	// only the source columns this region's taps read go through the line;
+	// colTable indexes into it
+	const auto [colMin, colMax] = std::minmax_element(colTable.index.begin(), colTable.index.end());
+	const int srcX0 = *colMin;
+	const int srcCols = *colMax - srcX0 + 1;
+	for (int& i : colTable.index)
+		i -= srcX0;
+
+	withChannels(img.channels, [&](auto count)
 	{
-		auto sImgPt = Point<int>(i % sImg.cols, i / sImg.cols);
-        // Find corresponding position in the original image (source pixel)
-		float scaledToOrigX = sImgPt.x / (float)scale;
-		float scaledToOrigY = sImgPt.y / (float)scale;
-
-		// Ensure within bounds
-        if (scaledToOrigX < 0 || scaledToOrigX >= img.cols || scaledToOrigY < 0 || scaledToOrigY >= img.rows)
-			continue;
-		
-		// neighbours
-		Point<int> ul(std::floor(scaledToOrigX), std::floor(scaledToOrigY));
-		Point<int> lr(std::ceil(scaledToOrigX), std::ceil(scaledToOrigY));
-		lr.x = std::min(lr.x, img.cols - 1);
-		lr.y = std::min(lr.y, img.rows - 1);
-		
-		Point<int> ur(lr.x, ul.y);
-		ur.x = std::min(ur.x, img.cols - 1);
-		ur.y = std::min(ur.y, img.rows - 1);
-		
-		Point<int> ll(ul.x, lr.y);
-
-		float a = std::fabs( lr.x - scaledToOrigX );
-		float b = std::fabs( lr.y - scaledToOrigY );
-		
-		// pixel = (1 - a)(1 - b)P00 + a(1 - b)P10 + (1 - a)bP01 + abP1
-	
-		Pixel ulPix = img.getPixel(ul.y, ul.x);
-		Pixel urPix = img.getPixel(ur.y, ur.x);
-		Pixel llPix = img.getPixel(ll.y, ll.x);
-		Pixel lrPix = img.getPixel(lr.y, lr.x);
-
-		// Copy pixel data from original image to scaled image
-		sImg.setPixel(sImgPt.y, sImgPt.x, Pixel{
-			.r = static_cast<uint8_t>( (1 - a) * (1 - b) * ulPix.r + a * (1 - b) * urPix.r + (1 - a) * b * llPix.r + a * b * lrPix.r ),
-			.g = static_cast<uint8_t>( (1 - a) * (1 - b) * ulPix.g + a * (1 - b) * urPix.g + (1 - a) * b * llPix.g + a * b * lrPix.g ),
-			.b = static_cast<uint8_t>( (1 - a) * (1 - b) * ulPix.b + a * (1 - b) * urPix.b + (1 - a) * b * llPix.b + a * b * lrPix.b )
-			
-		});
-	}
+		constexpr int C = decltype(count)::value;
+		const int channels = C != 0 ? C : img.channels;
+		const int srcElems = srcCols * channels;
+
+		parallelFor(0, sImg.rows, [&](int yBegin, int yEnd)
+		{
+			std::vector<float> line(srcElems);
+			for (int y = yBegin; y < yEnd; y++)
+			{
+				// vertical
+				std::fill(line.begin(), line.end(), 0.f);
+				for (int k = 0; k < rowTable.taps; k++)
+				{
+					const float w = rowTable.weight[y * rowTable.taps + k];
+					if (w == 0.f)
+						continue;
+					const uint8_t* src = img.row(rowTable.index[y * rowTable.taps + k]) + srcX0 * channels;
+					for (int i = 0; i < srcElems; i++)
+						line[i] += w * src[i];
+				}
+
+				// horizontal; locals, since the uint8 stores could alias the tables
+				uint8_t* dst = sImg.row(y);
+				const float* in = line.data();
+				const int taps = colTable.taps;
+				const int* index = colTable.index.data();
+				const float* weight = colTable.weight.data();
+				for (int x = 0; x < sImg.cols; x++, index += taps, weight += taps)
+				{
+					for (int c = 0; c < channels; c++)
+					{
+						float acc = 0.f;
+						for (int k = 0; k < taps; k++)
+							acc += weight[k] * in[index[k] * channels + c];
+						dst[x * channels + c] = static_cast<uint8_t>(std::min(acc + 0.5f, 255.f));
+					}
+				}
+			}
+		}, 8);
+	});
+}
 
+Image Scale::resize(const Image& img, const int rows, const int cols,
+			const InterpolationMethod intMethod)
+{
+	if (img.empty() || rows <= 0 || cols <= 0)
+		return Image{};
+
+	Image sImg(rows, cols, img.channels, ImageInit::Uninitialized);
+	resizeRegion(img.view(), sImg.view(), rows, cols, 0, 0, intMethod);
 	return sImg;
 }
 
+void Scale::resizeRegion(ConstImageView src, ImageView dst, const int rows, const int cols,
+	const int y0, const int x0, const InterpolationMethod intMethod)
+{
+	if (src.empty() || dst.empty())
+		return;
+
+	if (intMethod == InterpolationMethod::NearestNeighbour)
+		nearestNeighbour(src, dst, rows, cols, y0, x0);
+	else
+		separable(src, dst, rows, cols, y0, x0, intMethod);
+}
+
 Image Scale::scale(const Image& img,
 			const InterpolationMethod intMethod,
-			const uint8_t scale)
+			const double scale)
 {
 	// uniform scaling: aspect ratio is maintained
 
 	if (img.empty())
 		return Image{};
 
-	if (scale == 0)
+	if (scale <= 0)
 		return img;
 
-	Image sImg(img.rows, img.cols, img.channels);
-	if (intMethod == InterpolationMethod::NearestNeighbour)
-		sImg = nearestNeighbour(img, scale);
-	else if (intMethod == InterpolationMethod::Bilinear)
-		sImg = bilinear(img, scale);
-
-	return sImg;
+	const int rows = std::max(1, static_cast<int>(std::lround(img.rows * scale)));
+	const int cols = std::max(1, static_cast<int>(std::lround(img.cols * scale)));
+	return resize(img, rows, cols, intMethod);
 }
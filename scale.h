@@ -10,17 +10,35 @@ namespace imgproc
         enum class InterpolationMethod
         {
             NearestNeighbour,
-            Bilinear
+            Bilinear,
+            // box filter over the covered source area; anti-aliased
+            // downscaling (upscaling falls back to Bilinear)
+            Area
         };
 
+        // uniform scaling: aspect ratio is maintained. any positive factor,
+        // e.g. 2, 0.5 or 2.0 / 3 (1920 -> 1280)
         static Image scale(const Image& img,
             const InterpolationMethod intMethod,
-            const uint8_t scale);
+            const double scale);
+
+        // resample to an exact size
+        static Image resize(const Image& img, const int rows, const int cols,
+            const InterpolationMethod intMethod);
+
+        // rows [y0, y0 + dst.rows) and columns [x0, x0 + dst.cols) of
+        // resize(src, rows, cols), reading only the source pixels they need;
+        // for tiled evaluation (tiled.h)
+        static void resizeRegion(ConstImageView src, ImageView dst,
+            const int rows, const int cols, const int y0, const int x0,
+            const InterpolationMethod intMethod);
 
     private:
 
-        static Image nearestNeighbour(const Image& img,
-            const uint8_t scale);
-        static Image bilinear(const Image& img, const uint8_t scale);
+        static void nearestNeighbour(ConstImageView img, ImageView sImg,
+            const int rows, const int cols, const int y0, const int x0);
+        static void separable(ConstImageView img, ImageView sImg,
+            const int rows, const int cols, const int y0, const int x0,
+            const InterpolationMethod intMethod);
     };
 }
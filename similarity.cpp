@@ -1,18 +1,45 @@
 #include "similarity.h"
 #include "imgOps.h"
-#include "scale.h"
 #include "rotate.h"
-#include "translate.h"
+#include "warp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 
 imgproc::Image
 imgproc::similarityTransform(const Image &img)
 {
-    // scale, rotate, translate
-    return translate(
-            Rotation::rotate(
-                Scale::scale(img, Scale::InterpolationMethod::NearestNeighbour, 2), 
-                45, Rotation::rotateMethod::INV_MAP
-                ), 
-                100, 100
-            );
+    WarpOptions options;
+    options.interpolation = Interpolation::NearestNeighbour;
+    return similarityTransform(img, 2, 45, 100, 100, options);
+}
+
+imgproc::Image
+imgproc::similarityTransform(const Image &img, double scale, double angle,
+    int tx, int ty, const WarpOptions& options)
+{
+    if (img.empty() || scale <= 0)
+        return Image{};
+
+    // scale as Scale::scale sizes it, pixel centres to pixel centres
+    const int scaledRows = std::max(1, static_cast<int>(std::lround(img.rows * scale)));
+    const int scaledCols = std::max(1, static_cast<int>(std::lround(img.cols * scale)));
+    AffineMatrix m = AffineMatrix::translation(-0.5, -0.5) *
+        AffineMatrix::scaling(static_cast<double>(scaledCols) / img.cols,
+            static_cast<double>(scaledRows) / img.rows) *
+        AffineMatrix::translation(0.5, 0.5);
+
+    // rotate onto the canvas Rotation::rotate would make
+    int rows = 0, cols = 0;
+    m = Rotation::canvas(scaledRows, scaledCols, angle, rows, cols) * m;
+
+    // translate; the canvas grows by |t| so nothing is cropped
+    m = AffineMatrix::translation(std::max(tx, 0), std::max(ty, 0)) * m;
+
+    WarpOptions warpOptions = options;
+    warpOptions.rows = rows + std::abs(ty);
+    warpOptions.cols = cols + std::abs(tx);
+
+    return warpAffine(img, m, warpOptions);
 }
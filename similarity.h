@@ -1,8 +1,19 @@
 #pragma once
 
 #include "imgOps.h"
+#include "warp.h"
 
 namespace imgproc 
 {
+    // scale 2x (nearest neighbour), rotate 45 degrees, translate by (100, 100)
     Image similarityTransform(const Image& img);
+
+    // Scale by `scale`, rotate CCW by `angle` degrees onto a canvas that fits
+    // the rotated image, then translate by (tx, ty) growing the canvas like
+    // translate() does. The output is the size Scale::scale, Rotation::rotate
+    // and translate() chained would give. Composed into one matrix and done
+    // in a single warp; options.rows/cols are ignored since the canvas size is
+    // derived. Returns an empty image for scale <= 0.
+    Image similarityTransform(const Image& img, double scale, double angle,
+        int tx, int ty, const WarpOptions& options = {});
 }
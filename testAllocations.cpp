@@ -0,0 +1,107 @@
+// cvfp_test_allocations: a chain of in-place operations on a moved-in image
+// touches the heap only while warming up. After the first few frames the
+// pixel buffers come back from the buffer pool, the kernel from its cache,
+// and nothing else may call operator new. Counted through a replaced global
+// operator new, as cvfp_bench does. Exits 1 on failure.
+//
+// Runs on one thread: with more, every band in flight has its own scratch
+// rows, and how many are in flight at once -- so when the pool has seen
+// them all -- is up to the scheduler.
+
+#include "GaussianFilter.h"
+#include "enhancements.h"
+#include "imgOps.h"
+#include "parallel.h"
+#include "testUtils.h"
+#include "translate.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <utility>
+
+using namespace imgproc;
+using namespace imgproc::test;
+
+// ---------------------------------------------------------------------------
+// allocation counting
+
+namespace
+{
+    std::atomic<size_t> allocationCount{ 0 };
+
+    void* countedAlloc(size_t bytes, size_t alignment)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        void* p = std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+}
+
+void* operator new(size_t bytes) { return countedAlloc(bytes, alignof(std::max_align_t)); }
+void* operator new[](size_t bytes) { return countedAlloc(bytes, alignof(std::max_align_t)); }
+void* operator new(size_t bytes, std::align_val_t a) { return countedAlloc(bytes, static_cast<size_t>(a)); }
+void* operator new[](size_t bytes, std::align_val_t a) { return countedAlloc(bytes, static_cast<size_t>(a)); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+// ---------------------------------------------------------------------------
+
+namespace
+{
+    // one frame through the chain; returns its checksum so nothing is
+    // optimised away
+    uint32_t frame(int rows, int cols, int channels, uint32_t seed)
+    {
+        Image img = noiseImage(rows, cols, channels, seed);
+        Image out = translate(
+            applyGuassian(
+                contrast(
+                    adjustBrightness(std::move(img), 20),
+                    1.3f),
+                5, 1.4f),
+            7, 5);
+
+        uint32_t sum = 0;
+        for (int y = 0; y < out.rows; y++)
+            sum += out.row(y)[(y * 7) % (out.cols * out.channels)];
+        return sum;
+    }
+}
+
+int main()
+{
+    uint32_t checksum = 0;
+    setNumThreads(1);
+
+    for (const int channels : { 1, 3 })
+    {
+        const int rows = 480, cols = 640;
+
+        // warm-up: fills the pool, the kernel cache and the thread pool
+        for (int i = 0; i < 3; i++)
+            checksum += frame(rows, cols, channels, i);
+
+        const size_t before = allocationCount.load();
+        for (int i = 0; i < 10; i++)
+            checksum += frame(rows, cols, channels, i);
+        const size_t allocations = allocationCount.load() - before;
+
+        check(allocations == 0, std::to_string(allocations) + " allocations over 10 frames at "
+            + std::to_string(rows) + "x" + std::to_string(cols) + "x" + std::to_string(channels));
+    }
+
+    std::printf("checksum %u\n", checksum);
+    return finish();
+}
@@ -0,0 +1,145 @@
+// cvfp_test_gaussian_simd: the SSE4.1 and AVX2 blur kernels against the
+// scalar path, which they must match bit for bit, the uint8 blur against
+// the same blur run in float, and pyrDown against blurring then keeping
+// every other row and column, which it must also match exactly, and the
+// fused gray blur against converting first.
+//
+// Widths that are not a multiple of the vector width exercise the scalar
+// tails, and a kernel with negative taps the clamping below 0 and above 255.
+// Levels the CPU lacks are skipped. Exits 1 on any mismatch.
+
+#include "GaussianFilter.h"
+#include "colorConvert.h"
+#include "cpuFeatures.h"
+#include "imgOps.h"
+#include "testUtils.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace imgproc;
+using namespace imgproc::test;
+
+namespace
+{
+    // noise over a ramp, with runs of 0 and 255 so sharpening overshoots
+    Image testImage(int rows, int cols, int channels)
+    {
+        Image img = noiseImage(rows, cols, channels);
+        for (int y = 0; y < rows; y++)
+            for (int i = 0; i < cols * channels; i++)
+            {
+                const int band = (i / channels / 5 + y / 3) % 4;
+                uint8_t& v = img.row(y)[i];
+                v = band == 0 ? 0 : band == 1 ? 255
+                    : static_cast<uint8_t>((i * 3 + y * 7 + (v >> 3)) & 0xFF);
+            }
+        return img;
+    }
+
+    const char* levelName(SimdLevel level)
+    {
+        switch (level)
+        {
+        case SimdLevel::Scalar: return "scalar";
+        case SimdLevel::SSE41: return "sse41";
+        case SimdLevel::AVX2: return "avx2";
+        }
+        return "?";
+    }
+
+    Image convolved(const Image& img, const Kernel& kernel)
+    {
+        Image out(img.rows, img.cols, img.channels, ImageInit::Uninitialized);
+        convolveSeparable(img.view(), out.view(), kernel);
+        return out;
+    }
+
+    // pyrDown, and the blur it fuses followed by plain decimation
+    int pyrDownDifference(const Image& img, const Kernel& kernel)
+    {
+        Image fused(img.rows / 2, img.cols / 2, img.channels, ImageInit::Uninitialized);
+        pyrDown(img.view(), fused.view(), kernel);
+
+        const Image blurred = convolved(img, kernel);
+        Image decimated(fused.rows, fused.cols, img.channels, ImageInit::Uninitialized);
+        for (int y = 0; y < decimated.rows; y++)
+            for (int x = 0; x < decimated.cols; x++)
+                for (int c = 0; c < img.channels; c++)
+                    decimated.row(y)[x * img.channels + c] = blurred.row(2 * y)[2 * x * img.channels + c];
+        return maxDifference(fused, decimated);
+    }
+}
+
+int main()
+{
+    const std::vector<Kernel> kernels = {
+        computeKernel(3, 1.f),
+        computeKernel(5, 1.4f),
+        computeKernel(7, 2.f),
+        // sharpening: negative taps, so sums leave [0, 255] both ways
+        Kernel{ -0.25f, 1.5f, -0.25f },
+        // unit gain but not smoothing: the float path
+        Kernel{ 0.5f, -1.f, 1.5f },
+    };
+    const int sizes[][2] = { { 20, 37 }, { 17, 16 }, { 33, 101 }, { 9, 3 } };
+
+    // sizes picked from sigma, including ones that must not reach the cast
+    check(gaussianKernelSize(1.4f) == 9, "gaussianKernelSize 1.4");
+    check(gaussianKernelSize(0.f) == 1 && gaussianKernelSize(-2.f) == 1, "gaussianKernelSize <= 0");
+    check(gaussianKernelSize(std::numeric_limits<float>::quiet_NaN()) == 1, "gaussianKernelSize NaN");
+    check(gaussianKernelSize(std::numeric_limits<float>::infinity()) == 255, "gaussianKernelSize inf");
+
+    const SimdLevel best = detectedSimdLevel();
+    for (const auto& size : sizes)
+        for (const int channels : { 1, 3, 4 })
+        {
+            const Image img = testImage(size[0], size[1], channels);
+            const std::string shape = std::to_string(size[0]) + "x" + std::to_string(size[1])
+                + "x" + std::to_string(channels);
+
+            setSimdLevel(SimdLevel::Scalar);
+            std::vector<Image> reference;
+            for (const Kernel& kernel : kernels)
+                reference.push_back(convolved(img, kernel));
+            const Image blurred = applyGuassian(img, 5, 1.4f);
+
+            for (const SimdLevel level : { SimdLevel::SSE41, SimdLevel::AVX2 })
+            {
+                if (level > best)
+                    continue;
+                setSimdLevel(level);
+                for (size_t k = 0; k < kernels.size(); k++)
+                    check(maxDifference(convolved(img, kernels[k]), reference[k]) == 0,
+                        std::string("convolveSeparable ") + levelName(level) + " kernel "
+                        + std::to_string(k) + " " + shape);
+                check(maxDifference(applyGuassian(img, 5, 1.4f), blurred) == 0,
+                    std::string("applyGuassian ") + levelName(level) + " " + shape);
+            }
+
+            for (const SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2 })
+            {
+                if (level > best)
+                    continue;
+                setSimdLevel(level);
+                for (size_t k = 0; k < kernels.size(); k++)
+                    check(pyrDownDifference(img, kernels[k]) == 0,
+                        std::string("pyrDown ") + levelName(level) + " kernel "
+                        + std::to_string(k) + " " + shape);
+            }
+
+            // fixed point against float: one grey level at most
+            setSimdLevel(best);
+            const Image viaFloat = convertTo<uint8_t>(applyGuassian(convertTo<float>(img), 5, 1.4f));
+            check(maxDifference(blurred, viaFloat) <= 1, "applyGuassian uint8 vs float " + shape);
+
+            // fused gray + blur: BGR and BGRA both come out gray
+            if (channels != 1)
+                check(maxDifference(applyGuassianGray(img, 5, 1.4f),
+                    applyGuassian(bgrToGray(img), 5, 1.4f)) == 0, "applyGuassianGray " + shape);
+        }
+
+    return finish();
+}
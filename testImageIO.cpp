@@ -0,0 +1,51 @@
+// cvfp_test_image_io: writing a raw frame or PGM back over the file it is
+// mapped from. The writers fill a temporary file and rename it over the
+// target, so the mapped source must still read back intact rather than as
+// the zeroes a truncated file would give. Exits 1 on any mismatch.
+
+#include "imageIO.h"
+#include "imgOps.h"
+#include "testUtils.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+
+using namespace imgproc;
+using namespace imgproc::test;
+
+namespace fs = std::filesystem;
+
+int main()
+{
+    const fs::path dir = fs::temp_directory_path() / "cvfp_test_image_io";
+    fs::create_directories(dir);
+
+    Image frame(64, 64, 1);
+    for (int y = 0; y < frame.rows; y++)
+        std::fill(frame.row(y), frame.row(y) + frame.cols, uint8_t{ 100 });
+
+    const std::string raw = (dir / "frame.raw").string();
+    check(writeRawFrame(raw, frame), "writeRawFrame");
+    {
+        const Image mapped = mapRawFrame<uint8_t>(raw);
+        check(maxDifference(mapped, frame) == 0, "mapRawFrame");
+        check(writeRawFrame(raw, mapped), "writeRawFrame over its own mapping");
+    }
+    check(maxDifference(mapRawFrame<uint8_t>(raw), frame) == 0, "raw frame after rewrite");
+
+    const std::string pgm = (dir / "frame.pgm").string();
+    check(writePnm(pgm, frame), "writePnm");
+    {
+        const Image mapped = mapPnm(pgm);
+        check(maxDifference(mapped, frame) == 0, "mapPnm");
+        check(writePnm(pgm, mapped), "writePnm over its own mapping");
+    }
+    check(maxDifference(readPnm(pgm), frame) == 0, "pgm after rewrite");
+
+    check(!fs::exists(raw + ".tmp") && !fs::exists(pgm + ".tmp"), "temporary files left behind");
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    return finish();
+}
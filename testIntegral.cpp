@@ -0,0 +1,140 @@
+// cvfp_test_integral: summed-area tables and the box statistics built on
+// them against brute-force sums, on buffers the pool hands back dirty --
+// each table's storage was first filled with 0xAB and released, so any
+// entry the build forgets to write shows up. Several threads, so the
+// bands and the carry between them are exercised. Exits 1 on failure.
+
+#include "IntegralImage.h"
+#include "bufferPool.h"
+#include "parallel.h"
+#include "testUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace imgproc;
+using namespace imgproc::test;
+
+namespace
+{
+    // park a dirty buffer the size of a rows x cols x channels table of T
+    template <typename T>
+    void scribblePool(int rows, int cols, int channels)
+    {
+        std::vector<T, PoolAllocator<T>> junk(static_cast<size_t>(rows + 1) * (cols + 1) * channels);
+        std::memset(junk.data(), 0xAB, junk.size() * sizeof(T));
+    }
+
+    // every entry of the table against the sums it should hold
+    template <typename T>
+    bool tableMatches(const Image& img, const IntegralTable<T>& table, bool squares)
+    {
+        const int channels = img.channels;
+        std::vector<uint64_t> columnSums(static_cast<size_t>(img.cols) * channels, 0);
+        for (int y = 0; y <= img.rows; y++)
+        {
+            if (y > 0)
+                for (int i = 0; i < img.cols * channels; i++)
+                {
+                    const uint64_t v = img.row(y - 1)[i];
+                    columnSums[i] += squares ? v * v : v;
+                }
+
+            std::vector<uint64_t> running(channels, 0);
+            for (int x = 0; x <= img.cols; x++)
+                for (int c = 0; c < channels; c++)
+                {
+                    if (x > 0)
+                        running[c] += columnSums[(x - 1) * channels + c];
+                    if (table.row(y)[x * channels + c] != static_cast<T>(running[c]))
+                        return false;
+                }
+        }
+        return true;
+    }
+
+    // mean and variance over the window cut off at the edges
+    void windowStats(const Image& img, int y, int x, int c, int radius,
+        double& mean, double& variance)
+    {
+        double sum = 0, squares = 0;
+        int n = 0;
+        for (int j = std::max(0, y - radius); j < std::min(img.rows, y + radius + 1); j++)
+            for (int i = std::max(0, x - radius); i < std::min(img.cols, x + radius + 1); i++)
+            {
+                const double v = img.row(j)[i * img.channels + c];
+                sum += v;
+                squares += v * v;
+                n++;
+            }
+        mean = sum / n;
+        variance = squares / n - mean * mean;
+    }
+}
+
+int main()
+{
+    setNumThreads(4);
+    const int sizes[][2] = { { 301, 257 }, { 64, 3 }, { 1, 9 } };
+
+    for (const auto& size : sizes)
+        for (const int channels : { 1, 2, 3, 4 })
+        {
+            const int rows = size[0], cols = size[1];
+            const Image img = noiseImage(rows, cols, channels);
+            const std::string shape = std::to_string(rows) + "x" + std::to_string(cols)
+                + "x" + std::to_string(channels);
+
+            scribblePool<uint32_t>(rows, cols, channels);
+            check(tableMatches(img, integral<uint32_t>(img.view()), false), "integral<uint32_t> " + shape);
+            scribblePool<uint64_t>(rows, cols, channels);
+            check(tableMatches(img, squaredIntegral<uint64_t>(img.view()), true), "squaredIntegral<uint64_t> " + shape);
+
+            for (const int radius : { 0, 1, 4, 40 })
+            {
+                scribblePool<uint32_t>(rows, cols, channels);
+                scribblePool<uint64_t>(rows, cols, channels);
+                const Image box = boxFilter(img, radius);
+                ImageF mean(rows, cols, channels, ImageInit::Uninitialized);
+                ImageF variance(rows, cols, channels, ImageInit::Uninitialized);
+                localMeanVariance(img.view(), mean.view(), variance.view(), radius);
+
+                int boxWrong = 0;
+                double meanError = 0, varianceError = 0;
+                for (int y = 0; y < rows; y++)
+                    for (int x = 0; x < cols; x++)
+                        for (int c = 0; c < channels; c++)
+                        {
+                            double m, v;
+                            windowStats(img, y, x, c, radius, m, v);
+                            const int i = x * channels + c;
+                            boxWrong += box.row(y)[i] != static_cast<int>(std::lround(m));
+                            meanError = std::max(meanError, std::abs(m - mean.row(y)[i]));
+                            varianceError = std::max(varianceError,
+                                std::abs(v - variance.row(y)[i]) / std::max(1.0, v));
+                        }
+
+                const std::string what = shape + " radius " + std::to_string(radius);
+                check(boxWrong == 0, "boxFilter " + what);
+                check(meanError < 1e-3, "localMean " + what);
+                check(varianceError < 1e-3, "localVariance " + what);
+            }
+        }
+
+    // a window just big enough that the rounding checks' (q + 1) * area
+    // passes 2^32 while the sums themselves still fit in 32 bits
+    {
+        const int radius = 2048;
+        Image white(2 * radius + 1, 2 * radius + 1, 1);
+        for (int y = 0; y < white.rows; y++)
+            std::fill(white.row(y), white.row(y) + white.cols, uint8_t{ 255 });
+        const Image box = boxFilter(white, radius);
+        check(box.row(radius)[radius] == 255, "boxFilter white, radius 2048");
+    }
+
+    return finish();
+}
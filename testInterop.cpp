@@ -0,0 +1,70 @@
+// cvfp_test_interop: cv::Mat <-> Image wrapping shares pixels where it is
+// meant to and never lets a const Mat or const Image be written through
+// what comes back. Exits 1 on failure.
+
+#include "cvInterop.h"
+#include "imgOps.h"
+#include "testUtils.h"
+
+#include <opencv2/core/mat.hpp>
+
+#include <cstdint>
+
+using namespace imgproc;
+using namespace imgproc::test;
+
+namespace
+{
+    cv::Mat testMat(int rows, int cols)
+    {
+        cv::Mat mat(rows, cols, CV_8UC3);
+        for (int y = 0; y < rows; y++)
+            for (int i = 0; i < cols * 3; i++)
+                mat.ptr(y)[i] = static_cast<uint8_t>(y * 7 + i);
+        return mat;
+    }
+
+    bool matUnchanged(const cv::Mat& mat)
+    {
+        for (int y = 0; y < mat.rows; y++)
+            for (int i = 0; i < mat.cols * 3; i++)
+                if (mat.ptr(y)[i] != static_cast<uint8_t>(y * 7 + i))
+                    return false;
+        return true;
+    }
+}
+
+int main()
+{
+    // a non-const Mat is borrowed: writes show up in the Mat
+    {
+        cv::Mat mat = testMat(5, 6);
+        Image img = wrapMat(mat);
+        img.row(1)[2] = 200;
+        check(mat.ptr(1)[2] == 200, "wrapMat(cv::Mat&) shares the pixels");
+    }
+
+    // a const Mat is copied, however the result is held
+    {
+        const cv::Mat mat = testMat(5, 6);
+        Image img = wrapMat(mat);
+        auto deduced = wrapMat(mat);
+        check(img.rows == 5 && img.cols == 6 && img.channels == 3, "wrapMat(const cv::Mat&) shape");
+        check(img.row(1)[2] == mat.ptr(1)[2], "wrapMat(const cv::Mat&) pixels");
+        img.row(1)[2] = 200;
+        deduced.row(3)[4] = 201;
+        check(matUnchanged(mat), "writes through wrapMat(const cv::Mat&) reach the Mat");
+    }
+
+    // a const Image gives a Mat of its own
+    {
+        const Image img = noiseImage(4, 9, 3);
+        const uint8_t before = img.row(2)[5];
+        cv::Mat mat = imgToMat(img);
+        check(mat.rows == 4 && mat.cols == 9 && mat.ptr(2)[5] == before, "imgToMat(const Image&) pixels");
+        mat.ptr(2)[5] = static_cast<uint8_t>(before + 1);
+        check(img.row(2)[5] == before, "writes through imgToMat(const Image&) reach the Image");
+    }
+
+    return finish();
+}
@@ -0,0 +1,58 @@
+// cvfp_test_laplacian: reconstruct() inverts getLaplacianPyramid() byte for
+// byte, and LaplacianBands streams the same bands and residual as the whole
+// pyramid, for gray and colour, odd sizes and fixed or sigma-picked kernels.
+// Exits 1 on failure.
+
+#include "GaussianFilter.h"
+#include "LaplacianPyramid.h"
+#include "imgOps.h"
+#include "testUtils.h"
+
+#include <cstring>
+#include <string>
+
+using namespace imgproc;
+using namespace imgproc::test;
+
+namespace
+{
+    bool sameBand(const LaplacianBand& a, const LaplacianBand& b)
+    {
+        return a.rows == b.rows && a.cols == b.cols && a.channels == b.channels
+            && std::memcmp(a.data.data(), b.data.data(), a.data.size() * sizeof(int16_t)) == 0;
+    }
+}
+
+int main()
+{
+    const int sizes[][2] = { { 97, 131 }, { 64, 64 }, { 45, 33 }, { 3, 200 } };
+
+    for (const auto& size : sizes)
+        for (const int channels : { 1, 3 })
+            for (const uint8_t kernelSize : { 3, 5, 0 })
+            {
+                const Image img = noiseImage(size[0], size[1], channels);
+                PyramidOptions options;
+                options.kernelSize = kernelSize;
+                options.minSize = 8;
+                const std::string what = std::to_string(size[0]) + "x" + std::to_string(size[1])
+                    + "x" + std::to_string(channels) + " kernel " + std::to_string(kernelSize);
+
+                const LaplacianPyramid pyramid = getLaplacianPyramid(img, options);
+                check(maxDifference(reconstruct(pyramid), img) == 0, "reconstruct " + what);
+
+                LaplacianBands bands(img, options);
+                LaplacianBand band;
+                size_t level = 0;
+                bool same = true;
+                while (bands.next(band))
+                {
+                    same = same && level < pyramid.bands.size() && sameBand(band, pyramid.bands[level]);
+                    level++;
+                }
+                check(same && level == pyramid.bands.size(), "streamed bands " + what);
+                check(maxDifference(bands.residual(), pyramid.residual) == 0, "streamed residual " + what);
+            }
+
+    return finish();
+}
@@ -0,0 +1,88 @@
+// cvfp_test_parallel: parallelFor covers every row exactly once, rethrows
+// an exception thrown by any band on the calling thread, and leaves the
+// pool usable -- and running in parallel -- afterwards. Exits 1 on failure.
+
+#include "parallel.h"
+#include "testUtils.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace imgproc;
+using namespace imgproc::test;
+
+namespace
+{
+    // every row visited once, and whether the bands were split at all
+    bool coversOnce(int rows, int& calls)
+    {
+        std::vector<std::atomic<int>> visits(rows);
+        std::atomic<int> bands{ 0 };
+        parallelFor(0, rows, [&](int rowBegin, int rowEnd)
+        {
+            bands++;
+            for (int y = rowBegin; y < rowEnd; y++)
+                visits[y]++;
+        });
+        calls = bands;
+        for (const std::atomic<int>& v : visits)
+            if (v != 1)
+                return false;
+        return true;
+    }
+
+    // throws from the band holding `row`; true if parallelFor rethrew it
+    bool rethrows(int rows, int row)
+    {
+        try
+        {
+            parallelFor(0, rows, [&](int rowBegin, int rowEnd)
+            {
+                if (rowBegin <= row && row < rowEnd)
+                    throw std::runtime_error("band " + std::to_string(row));
+            });
+        }
+        catch (const std::runtime_error& e)
+        {
+            return e.what() == "band " + std::to_string(row);
+        }
+        return false;
+    }
+}
+
+int main()
+{
+    // more threads than cores is fine: this checks bookkeeping, not speed
+    setNumThreads(4);
+    const int rows = 1000;
+
+    int calls = 0;
+    check(coversOnce(rows, calls) && calls > 1, "parallelFor before a throw");
+
+    // first band (the caller's queue), last band (a worker's), one in between
+    for (const int row : { 0, rows - 1, rows / 2 })
+    {
+        check(rethrows(rows, row), "rethrow from row " + std::to_string(row));
+        check(coversOnce(rows, calls), "parallelFor after a throw from row " + std::to_string(row));
+        check(calls > 1, "still split into bands after a throw from row " + std::to_string(row));
+    }
+
+    // a nested call that throws unwinds through the outer band
+    try
+    {
+        parallelFor(0, rows, [&](int rowBegin, int)
+        {
+            if (rowBegin == 0)
+                parallelFor(0, 10, [](int, int) { throw std::logic_error("nested"); });
+        });
+        check(false, "nested throw was swallowed");
+    }
+    catch (const std::logic_error&)
+    {
+    }
+    check(coversOnce(rows, calls) && calls > 1, "parallelFor after a nested throw");
+
+    return finish();
+}
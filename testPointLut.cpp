@@ -0,0 +1,91 @@
+// cvfp_test_point_lut: PointLut::apply on the scalar, SSE4.1 and AVX2 row
+// kernels against a plain table[v] loop, which each must match bit for bit,
+// copying and in place. Random tables reach every entry of every 16-entry
+// sub-table the vector kernels split the table into.
+//
+// Row lengths that are not a multiple of 16 or 32 exercise the scalar
+// tails. Levels the CPU lacks are skipped. Exits 1 on any mismatch.
+
+#include "cpuFeatures.h"
+#include "imgOps.h"
+#include "pointLut.h"
+#include "testUtils.h"
+
+#include <string>
+#include <vector>
+
+using namespace imgproc;
+using namespace imgproc::test;
+
+namespace
+{
+    const char* levelName(SimdLevel level)
+    {
+        switch (level)
+        {
+        case SimdLevel::Scalar: return "scalar";
+        case SimdLevel::SSE41: return "sse41";
+        case SimdLevel::AVX2: return "avx2";
+        }
+        return "?";
+    }
+
+    // a random table, built with curve() through a control point per entry
+    PointLut randomLut(uint32_t seed)
+    {
+        Lcg lcg{ seed };
+        std::vector<Point<int>> points;
+        for (int i = 0; i < 256; i++)
+            points.push_back(Point<int>(i, lcg.nextByte()));
+        return PointLut().curve(points);
+    }
+
+    Image lookedUp(const Image& img, const PointLut& lut)
+    {
+        Image out(img.rows, img.cols, img.channels, ImageInit::Uninitialized);
+        for (int y = 0; y < img.rows; y++)
+            for (int i = 0; i < img.cols * img.channels; i++)
+                out.row(y)[i] = lut[img.row(y)[i]];
+        return out;
+    }
+}
+
+int main()
+{
+    const std::vector<PointLut> luts = {
+        randomLut(1),
+        randomLut(2),
+        PointLut().invert(),
+        PointLut().brightness(20).contrast(1.2f).gamma(0.8f),
+    };
+    const int sizes[][2] = { { 5, 1 }, { 7, 15 }, { 9, 33 }, { 20, 101 }, { 3, 64 } };
+
+    const SimdLevel best = detectedSimdLevel();
+    for (const auto& size : sizes)
+        for (const int channels : { 1, 3 })
+        {
+            const Image img = noiseImage(size[0], size[1], channels);
+            const std::string shape = std::to_string(size[0]) + "x" + std::to_string(size[1])
+                + "x" + std::to_string(channels);
+
+            for (size_t k = 0; k < luts.size(); k++)
+            {
+                const Image expected = lookedUp(img, luts[k]);
+                for (const SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2 })
+                {
+                    if (level > best)
+                        continue;
+                    setSimdLevel(level);
+                    const std::string what = std::string(levelName(level)) + " table "
+                        + std::to_string(k) + " " + shape;
+                    check(maxDifference(luts[k].apply(img), expected) == 0, "apply " + what);
+
+                    Image inPlace = img;
+                    luts[k].applyInPlace(inPlace);
+                    check(maxDifference(inPlace, expected) == 0, "applyInPlace " + what);
+                }
+            }
+        }
+
+    return finish();
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+// Shared by the cvfp_test_* checks (and cvfp_bench's synthetic frames):
+// a failure count with check()/finish(), and deterministic images, so
+// every run of every test sees the same pixels.
+
+#include "imgOps.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace imgproc::test
+{
+    inline int failures = 0;
+
+    // counts and reports a failed expectation; the test carries on
+    inline void check(bool ok, const std::string& what)
+    {
+        if (!ok)
+        {
+            failures++;
+            std::printf("FAIL %s\n", what.c_str());
+        }
+    }
+
+    // prints the verdict; main's exit code
+    inline int finish()
+    {
+        std::printf("%s\n", failures == 0 ? "ok" : "failed");
+        return failures == 0 ? 0 : 1;
+    }
+
+    // 32-bit linear congruential generator (Numerical Recipes constants);
+    // the top bits are the usable ones
+    struct Lcg
+    {
+        uint32_t state;
+
+        uint32_t next()
+        {
+            state = state * 1664525u + 1013904223u;
+            return state;
+        }
+        uint8_t nextByte() { return static_cast<uint8_t>(next() >> 24); }
+    };
+
+    // uniform noise, the same for the same arguments
+    inline Image noiseImage(int rows, int cols, int channels, uint32_t seed = 7)
+    {
+        Image img(rows, cols, channels, ImageInit::Uninitialized);
+        Lcg lcg{ seed };
+        for (int y = 0; y < rows; y++)
+            for (int i = 0; i < cols * channels; i++)
+                img.row(y)[i] = lcg.nextByte();
+        return img;
+    }
+
+    // largest difference between two images; 256 if their shapes differ
+    inline int maxDifference(const Image& a, const Image& b)
+    {
+        if (a.rows != b.rows || a.cols != b.cols || a.channels != b.channels)
+            return 256;
+        int worst = 0;
+        for (int y = 0; y < a.rows; y++)
+            for (int i = 0; i < a.cols * a.channels; i++)
+                worst = std::max(worst, std::abs(a.row(y)[i] - b.row(y)[i]));
+        return worst;
+    }
+}
@@ -0,0 +1,109 @@
+// Tile-by-tile evaluation with halos, for images larger than memory
+
+#include "tiled.h"
+#include "GaussianFilter.h"
+#include "parallel.h"
+#include "rotate.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace imgproc;
+
+namespace
+{
+    // body(y0, x0, rows, cols) for every tile of a rows x cols image, tiles
+    // spread over the threads
+    template <typename Body>
+    void tiles(int rows, int cols, const TileOptions& options, const Body& body)
+    {
+        const int tileRows = std::max(1, options.tileRows);
+        const int tileCols = std::max(1, options.tileCols);
+        const int across = (cols + tileCols - 1) / tileCols;
+        const int down = (rows + tileRows - 1) / tileRows;
+
+        parallelFor(0, across * down, [&](int tBegin, int tEnd)
+        {
+            for (int t = tBegin; t < tEnd; t++)
+            {
+                const int y0 = (t / across) * tileRows;
+                const int x0 = (t % across) * tileCols;
+                body(y0, x0, std::min(tileRows, rows - y0), std::min(tileCols, cols - x0));
+            }
+        });
+    }
+}
+
+void imgproc::forEachTile(ConstImageView src, ImageView dst, int halo,
+    const TileFn& fn, const TileOptions& options)
+{
+    if (src.empty() || dst.rows != src.rows || dst.cols != src.cols || dst.channels != src.channels)
+        return;
+
+    halo = std::max(halo, 0);
+    tiles(src.rows, src.cols, options, [&](int y0, int x0, int rows, int cols)
+    {
+        // the tile plus its halo, as far as the image goes
+        const int top = std::max(0, y0 - halo);
+        const int left = std::max(0, x0 - halo);
+        const int bottom = std::min(src.rows, y0 + rows + halo);
+        const int right = std::min(src.cols, x0 + cols + halo);
+
+        Image scratch(bottom - top, right - left, src.channels, ImageInit::Uninitialized);
+        fn(src.roi(top, left, bottom - top, right - left), scratch.view());
+
+        for (int y = 0; y < rows; y++)
+            std::memcpy(dst.ptr(y0 + y, x0), scratch.view().ptr(y0 - top + y, x0 - left),
+                static_cast<size_t>(cols) * src.channels);
+    });
+}
+
+void imgproc::applyGuassianTiled(ConstImageView src, ImageView dst,
+    const uint8_t kernelSize, const float stdDev, const TileOptions& options)
+{
+    // the black border convolveSeparable gives a tile's edges is only ever
+    // read by halo pixels, except at the edges of the image, where it is
+    // the border applyGuassian has too
+    const auto kernel = gaussianKernel(kernelSize, stdDev);
+    forEachTile(src, dst, static_cast<int>(kernel->weights.size() / 2), [&](ConstImageView in, ImageView out)
+    {
+        convolveSeparable(in, out, *kernel);
+    }, options);
+}
+
+void imgproc::resizeTiled(ConstImageView src, ImageView dst,
+    Scale::InterpolationMethod method, const TileOptions& options)
+{
+    if (src.empty() || dst.empty() || dst.channels != src.channels)
+        return;
+
+    tiles(dst.rows, dst.cols, options, [&](int y0, int x0, int rows, int cols)
+    {
+        Scale::resizeRegion(src, dst.roi(y0, x0, rows, cols), dst.rows, dst.cols, y0, x0, method);
+    });
+}
+
+void imgproc::warpAffineTiled(ConstImageView src, ImageView dst, const AffineMatrix& m,
+    const WarpOptions& warp, const TileOptions& options)
+{
+    if (src.empty() || dst.empty() || dst.channels != src.channels || !m.invertible())
+        return;
+
+    tiles(dst.rows, dst.cols, options, [&](int y0, int x0, int rows, int cols)
+    {
+        detail::warpAffineRows(src, 0, src.rows, dst.roi(y0, x0, rows, cols), y0, x0, m, warp);
+    });
+}
+
+void imgproc::rotateTiled(ConstImageView src, ImageView dst, double angle,
+    Interpolation interpolation, const TileOptions& options)
+{
+    int rows = 0, cols = 0;
+    const AffineMatrix m = Rotation::canvas(src.rows, src.cols, angle, rows, cols);
+    if (dst.rows != rows || dst.cols != cols)
+        return;
+
+    WarpOptions warp;
+    warp.interpolation = interpolation;
+    warpAffineTiled(src, dst, m, warp, options);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "imgOps.h"
+#include "scale.h"
+#include "warp.h"
+
+#include <functional>
+
+namespace imgproc
+{
+    // Tile-by-tile versions of the ops for images too big to hold in memory,
+    // usually with src and dst mapped from files (imageIO.h). Each tile reads
+    // only the source pixels it needs and writes its own part of dst, and the
+    // only buffers are per-tile scratch, so memory use depends on the tile
+    // size, not the image size. Tiles run in parallel, and give exactly the
+    // pixels the whole-image op would. dst must not overlap src.
+    struct TileOptions
+    {
+        int tileRows = 256;
+        int tileCols = 256;
+    };
+
+    // For neighbourhood ops: fn(in, out) gets a tile of src grown by `halo`
+    // pixels on every side (clipped at the image edge) and a scratch `out`
+    // of the same size, of which the tile's own pixels are copied into dst.
+    // dst is src's size.
+    using TileFn = std::function<void(ConstImageView in, ImageView out)>;
+    void forEachTile(ConstImageView src, ImageView dst, int halo,
+        const TileFn& fn, const TileOptions& options = {});
+
+    // applyGuassian; dst is src's size
+    void applyGuassianTiled(ConstImageView src, ImageView dst,
+        const uint8_t kernelSize, const float stdDev, const TileOptions& options = {});
+
+    // Scale::resize to dst's size
+    void resizeTiled(ConstImageView src, ImageView dst,
+        Scale::InterpolationMethod method, const TileOptions& options = {});
+
+    // warpAffine into dst, which sets the output size (warp.rows/cols are
+    // ignored); a singular m leaves dst untouched
+    void warpAffineTiled(ConstImageView src, ImageView dst, const AffineMatrix& m,
+        const WarpOptions& warp = {}, const TileOptions& options = {});
+
+    // Rotation::rotate's canvas, sampled through warpAffine; dst must be the
+    // size Rotation::canvas gives
+    void rotateTiled(ConstImageView src, ImageView dst, double angle,
+        Interpolation interpolation = Interpolation::NearestNeighbour,
+        const TileOptions& options = {});
+}
@@ -1,7 +1,8 @@
 #include "imgOps.h"
 #include "translate.h"
 
-#include <iostream>
+#include <cstdlib>
+#include <utility>
 
 using namespace imgproc;
 
@@ -18,10 +19,7 @@ Image imgproc::translate(const Image& img, int tx, int ty)
     int newWidth = img.cols + std::abs(tx);
     int newHeight = img.rows + std::abs(ty);
 
-    Image translatedImg(newHeight, newWidth, img.channels);
-
-    int cStart = tx < 0 ? 0 : translatedImg.cols - img.cols;
-    int rStart = ty < 0 ? 0 : translatedImg.rows - img.rows;
+    Image translatedImg(newHeight, newWidth, img.channels, ImageInit::Uninitialized);
 
     /*
         original image:        translated image
@@ -32,13 +30,25 @@ Image imgproc::translate(const Image& img, int tx, int ty)
                                Y Y X X
     */
 
-    for (int r = rStart; r < translatedImg.rows; r++)
-    {
-        for (int c = cStart; c < translatedImg.cols; c++)
-        {
-            translatedImg.setPixel(r, c, img.getPixel(r - rStart, c - cStart));
-        }
-    }
+    translate(img.view(), translatedImg.view(), tx, ty);
     
     return translatedImg;
 }
+
+Image imgproc::translate(Image&& img, int tx, int ty)
+{
+    if (tx == 0 && ty == 0)
+        return std::move(img);
+
+    return translate(static_cast<const Image&>(img), tx, ty);
+}
+
+void imgproc::translate(ConstImageView src, ImageView dst, int tx, int ty)
+{
+    int cStart = tx < 0 ? 0 : tx;
+    int rStart = ty < 0 ? 0 : ty;
+
+    // every source row lands contiguously in the destination; only the
+    // uncovered border needs clearing
+    embed(src, dst, rStart, cStart);
+}
@@ -5,4 +5,9 @@
 namespace imgproc
 {
     Image translate(const Image& img, int tx, int ty);
+    // the canvas grows by |tx| x |ty|, so img's buffer can only be handed
+    // back as is when there is nothing to shift
+    Image translate(Image&& img, int tx, int ty);
+    // dst must be (rows + |ty|) x (cols + |tx|)
+    void translate(ConstImageView src, ImageView dst, int tx, int ty);
 }
@@ -0,0 +1,442 @@
+#include "warp.h"
+#include "imgOps.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace imgproc;
+
+AffineMatrix AffineMatrix::translation(double tx, double ty)
+{
+    return { { 1, 0, tx, 0, 1, ty } };
+}
+
+AffineMatrix AffineMatrix::scaling(double sx, double sy)
+{
+    return { { sx, 0, 0, 0, sy, 0 } };
+}
+
+AffineMatrix AffineMatrix::rotation(double angle, double cx, double cy)
+{
+    // CCW on screen with y pointing down (see Rotation::rotate)
+    const double rad = angle / 180.0 * PI;
+    const double c = std::cos(rad);
+    const double s = std::sin(rad);
+
+    // translate center to origin, rotate, translate back
+    return { { c, s, cx - c * cx - s * cy,
+              -s, c, cy + s * cx - c * cy } };
+}
+
+AffineMatrix AffineMatrix::operator*(const AffineMatrix& other) const
+{
+    const auto& a = m;
+    const auto& b = other.m;
+    return { { a[0] * b[0] + a[1] * b[3], a[0] * b[1] + a[1] * b[4], a[0] * b[2] + a[1] * b[5] + a[2],
+               a[3] * b[0] + a[4] * b[3], a[3] * b[1] + a[4] * b[4], a[3] * b[2] + a[4] * b[5] + a[5] } };
+}
+
+AffineMatrix AffineMatrix::inverse() const
+{
+    if (!invertible())
+        return identity();
+
+    const double det = m[0] * m[4] - m[1] * m[3];
+
+    const double i0 = m[4] / det;
+    const double i1 = -m[1] / det;
+    const double i3 = -m[3] / det;
+    const double i4 = m[0] / det;
+    return { { i0, i1, -(i0 * m[2] + i1 * m[5]),
+               i3, i4, -(i3 * m[2] + i4 * m[5]) } };
+}
+
+Point<double> AffineMatrix::apply(double x, double y) const
+{
+    return { m[0] * x + m[1] * y + m[2], m[3] * x + m[4] * y + m[5] };
+}
+
+AffineMatrix imgproc::fitCanvas(const AffineMatrix& m, int srcRows, int srcCols,
+    int& outRows, int& outCols)
+{
+    // pixel (x, y) covers [x - 0.5, x + 0.5]; bound the transformed area
+    const double left = -0.5, top = -0.5;
+    const double right = srcCols - 0.5, bottom = srcRows - 0.5;
+    const Point<double> corners[4] = { m.apply(left, top), m.apply(right, top),
+        m.apply(left, bottom), m.apply(right, bottom) };
+
+    double minX = corners[0].x, maxX = corners[0].x;
+    double minY = corners[0].y, maxY = corners[0].y;
+    for (const Point<double>& p : corners)
+    {
+        minX = std::min(minX, p.x);
+        maxX = std::max(maxX, p.x);
+        minY = std::min(minY, p.y);
+        maxY = std::max(maxY, p.y);
+    }
+
+    // tolerate rounding noise so exact multiples don't grow by a pixel
+    outCols = static_cast<int>(std::ceil(maxX - minX - 1e-6));
+    outRows = static_cast<int>(std::ceil(maxY - minY - 1e-6));
+
+    return AffineMatrix::translation(-minX - 0.5, -minY - 0.5) * m;
+}
+
+namespace
+{
+    // index used for a sample at i in a row/column of n pixels; -1 = border value
+    inline int borderIndex(int i, int n, BorderMode mode)
+    {
+        if (i >= 0 && i < n)
+            return i;
+
+        switch (mode)
+        {
+        case BorderMode::Replicate:
+            return i < 0 ? 0 : n - 1;
+        case BorderMode::Reflect:
+        {
+            // ... 2 1 | 0 1 2 ... n-1 | n-2 n-3 ...
+            if (n == 1)
+                return 0;
+            const int period = 2 * (n - 1);
+            i %= period;
+            if (i < 0)
+                i += period;
+            return i < n ? i : period - i;
+        }
+        case BorderMode::Constant:
+        default:
+            return -1;
+        }
+    }
+
+    // src holds rows [top, top + src.rows) of a `rows`-tall image (all of
+    // it, except when warping a band for tiled evaluation)
+    struct Sampler
+    {
+        ConstImageView src;
+        int top;
+        int rows;
+        BorderMode border;
+        // one pixel of the border value, so taps outside read like any other
+        const uint8_t* borderPixel;
+
+        const uint8_t* row(int y) const { return src.row(y - top); }
+
+        // pixel pointer for an arbitrary tap, or borderPixel
+        const uint8_t* tap(int y, int x) const
+        {
+            y = borderIndex(y, rows, border);
+            x = borderIndex(x, src.cols, border);
+            if (y < top || y >= top + src.rows || x < 0)
+                return borderPixel;
+            return row(y) + x * src.channels;
+        }
+
+
+        bool inside(int y0, int x0, int y1, int x1) const
+        {
+            return y0 >= top && x0 >= 0 && y1 < top + src.rows && x1 < src.cols;
+        }
+    };
+
+    // floor without the libm call std::floor is on baseline x86-64 (no
+    // SSE4.1 roundsd); the samplers need one per axis per pixel
+    inline int floorToInt(double v)
+    {
+        const int i = static_cast<int>(v);
+        return i - (v < i);
+    }
+
+    inline uint8_t toPixel(float v)
+    {
+        return static_cast<uint8_t>(std::clamp(v + 0.5f, 0.f, 255.f));
+    }
+
+    // the samplers take the channel count as C (0: read it from the source)
+    // so their channel loops have a fixed trip count for 1, 3 and 4 channels
+
+    template <int C>
+    void sampleNearest(const Sampler& s, double x, double y, uint8_t* out)
+    {
+        const int channels = C != 0 ? C : s.src.channels;
+        const int xi = floorToInt(x + 0.5);
+        const int yi = floorToInt(y + 0.5);
+        const uint8_t* p = s.tap(yi, xi);
+        for (int c = 0; c < channels; c++)
+            out[c] = p[c];
+    }
+
+    template <int C>
+    void sampleBilinear(const Sampler& s, double x, double y, uint8_t* out)
+    {
+        const int x0 = floorToInt(x);
+        const int y0 = floorToInt(y);
+        const double xf = x0;
+        const double yf = y0;
+        const float a = static_cast<float>(x - xf);
+        const float b = static_cast<float>(y - yf);
+        const int channels = C != 0 ? C : s.src.channels;
+
+        const uint8_t *ul, *ur, *ll, *lr;
+        if (s.inside(y0, x0, y0 + 1, x0 + 1))
+        {
+            ul = s.row(y0) + x0 * channels;
+            ur = ul + channels;
+            ll = ul + s.src.stride;
+            lr = ll + channels;
+        }
+        else
+        {
+            ul = s.tap(y0, x0);
+            ur = s.tap(y0, x0 + 1);
+            ll = s.tap(y0 + 1, x0);
+            lr = s.tap(y0 + 1, x0 + 1);
+        }
+
+        // pixel = (1 - a)(1 - b)P00 + a(1 - b)P10 + (1 - a)bP01 + abP11
+        for (int c = 0; c < channels; c++)
+        {
+            const float top = (1 - a) * ul[c] + a * ur[c];
+            const float bottom = (1 - a) * ll[c] + a * lr[c];
+            out[c] = toPixel((1 - b) * top + b * bottom);
+        }
+    }
+
+    // Keys cubic convolution, a = -0.5 (Catmull-Rom)
+    inline void cubicWeights(float t, float w[4])
+    {
+        constexpr float a = -0.5f;
+        const float t2 = t * t, t3 = t2 * t;
+        w[0] = a * (t3 - 2 * t2 + t);
+        w[1] = (a + 2) * t3 - (a + 3) * t2 + 1;
+        w[2] = -(a + 2) * t3 + (2 * a + 3) * t2 - a * t;
+        w[3] = -a * (t3 - t2);
+    }
+
+    template <int C>
+    void sampleBicubic(const Sampler& s, double x, double y, uint8_t* out)
+    {
+        const int x0 = floorToInt(x);
+        const int y0 = floorToInt(y);
+        const double xf = x0;
+        const double yf = y0;
+        float wx[4], wy[4];
+        cubicWeights(static_cast<float>(x - xf), wx);
+        cubicWeights(static_cast<float>(y - yf), wy);
+        const int channels = C != 0 ? C : s.src.channels;
+
+        const uint8_t* taps[4][4];
+        const bool inside = s.inside(y0 - 1, x0 - 1, y0 + 2, x0 + 2);
+        for (int j = 0; j < 4; j++)
+            for (int i = 0; i < 4; i++)
+                taps[j][i] = inside ? s.row(y0 - 1 + j) + (x0 - 1 + i) * channels
+                                    : s.tap(y0 - 1 + j, x0 - 1 + i);
+
+        for (int c = 0; c < channels; c++)
+        {
+            float acc = 0;
+            for (int j = 0; j < 4; j++)
+            {
+                float rowAcc = 0;
+                for (int i = 0; i < 4; i++)
+                    rowAcc += wx[i] * taps[j][i][c];
+                acc += wy[j] * rowAcc;
+            }
+            out[c] = toPixel(acc);
+        }
+    }
+
+    // Source positions along a row in 32.32 fixed point, as in
+    // Rotation::rotate: exact, so the runs of columns that read only the
+    // border, or only inside pixels, can be solved for once per row. Bilinear
+    // filters the inside run with 8-bit weights and no checks (within one
+    // grey level of sampleBilinear, which the fringe still takes).
+    constexpr int fracBits = 32;
+    constexpr int64_t one = int64_t(1) << fracBits;
+
+    int64_t toFixed(double v)
+    {
+        return static_cast<int64_t>(std::llround(v * static_cast<double>(one)));
+    }
+
+    // floor(a / b) for b > 0
+    int64_t floorDiv(int64_t a, int64_t b)
+    {
+        return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+
+    // first and last + 1 of the steps i in [begin, end) for which
+    // lo <= start + i * step < hi
+    void clip(int& begin, int& end, int64_t start, int64_t step, int64_t lo, int64_t hi)
+    {
+        int64_t first, last;
+        if (step > 0)
+        {
+            first = floorDiv(lo - start + step - 1, step);
+            last = floorDiv(hi - start + step - 1, step);
+        }
+        else if (step < 0)
+        {
+            first = floorDiv(start - hi, -step) + 1;
+            last = floorDiv(start - lo, -step) + 1;
+        }
+        else
+        {
+            const bool inside = start >= lo && start < hi;
+            first = inside ? begin : 0;
+            last = inside ? end : 0;
+        }
+
+        // kept within the old [begin, end), even when empty
+        const int64_t lo64 = begin, hi64 = end;
+        begin = static_cast<int>(std::min(std::max(first, lo64), hi64));
+        end = static_cast<int>(std::min(std::max(last, static_cast<int64_t>(begin)), hi64));
+    }
+
+    // with a constant border, fill the columns of a row whose samples
+    // cannot reach the image -- their taps all lie more than `reach` pixels
+    // outside it -- and narrow [begin, end) to the rest. out holds columns
+    // [first, first + cols)
+    void fillOutside(const Sampler& s, int64_t x0, int64_t y0, int64_t dx, int64_t dy,
+        int reach, uint8_t* out, int first, int cols, int& begin, int& end)
+    {
+        if (s.border != BorderMode::Constant)
+            return;
+
+        const int64_t margin = static_cast<int64_t>(reach) << fracBits;
+        clip(begin, end, x0, dx, -margin + 1, (static_cast<int64_t>(s.src.cols - 1) << fracBits) + margin);
+        clip(begin, end, y0, dy, -margin + 1, (static_cast<int64_t>(s.rows - 1) << fracBits) + margin);
+
+        const int channels = s.src.channels;
+        std::memset(out, s.borderPixel[0], static_cast<size_t>(begin - first) * channels);
+        std::memset(out + (end - first) * channels, s.borderPixel[0],
+            static_cast<size_t>(first + cols - end) * channels);
+    }
+
+    template <int C>
+    void bilinearRow(const Sampler& s, double rowX, double rowY, double stepX, double stepY,
+        uint8_t* out, int first, int cols)
+    {
+        const int channels = C != 0 ? C : s.src.channels;
+        const int64_t x0 = toFixed(rowX), y0 = toFixed(rowY);
+        const int64_t dx = toFixed(stepX), dy = toFixed(stepY);
+
+        int outerBegin = first, outerEnd = first + cols;
+        fillOutside(s, x0, y0, dx, dy, 1, out, first, cols, outerBegin, outerEnd);
+
+        // columns whose four taps are all inside
+        int begin = outerBegin, end = outerEnd;
+        clip(begin, end, x0, dx, 0, static_cast<int64_t>(s.src.cols - 1) << fracBits);
+        clip(begin, end, y0, dy, static_cast<int64_t>(s.top) << fracBits,
+            static_cast<int64_t>(s.top + s.src.rows - 1) << fracBits);
+        if (begin >= end)
+            begin = end = outerEnd;
+
+        for (int x = outerBegin; x < begin; x++)
+            sampleBilinear<C>(s, rowX + stepX * x, rowY + stepY * x, out + (x - first) * channels);
+
+        int64_t px = x0 + begin * dx;
+        int64_t py = y0 + begin * dy;
+        for (int x = begin; x < end; x++, px += dx, py += dy)
+        {
+            const uint8_t* ul = s.row(static_cast<int>(py >> fracBits))
+                + static_cast<int>(px >> fracBits) * channels;
+            const uint8_t* ll = ul + s.src.stride;
+            // weights rounded to [0, 256]
+            const int a = static_cast<int>(((px & (one - 1)) + (one >> 9)) >> (fracBits - 8));
+            const int b = static_cast<int>(((py & (one - 1)) + (one >> 9)) >> (fracBits - 8));
+            uint8_t* o = out + (x - first) * channels;
+            for (int c = 0; c < channels; c++)
+            {
+                const int top = ul[c] * (256 - a) + ul[c + channels] * a;
+                const int bottom = ll[c] * (256 - a) + ll[c + channels] * a;
+                o[c] = static_cast<uint8_t>((top * (256 - b) + bottom * b + (1 << 15)) >> 16);
+            }
+        }
+
+        for (int x = end; x < outerEnd; x++)
+            sampleBilinear<C>(s, rowX + stepX * x, rowY + stepY * x, out + (x - first) * channels);
+    }
+
+    using SampleFn = void (*)(const Sampler&, double, double, uint8_t*);
+
+    // taps of `sample` reach at most `reach` pixels from the sample position
+    template <int C, SampleFn sample, int reach>
+    void sampleRow(const Sampler& s, double rowX, double rowY, double stepX, double stepY,
+        uint8_t* out, int first, int cols)
+    {
+        const int channels = C != 0 ? C : s.src.channels;
+        int begin = first, end = first + cols;
+        fillOutside(s, toFixed(rowX), toFixed(rowY), toFixed(stepX), toFixed(stepY),
+            reach, out, first, cols, begin, end);
+        for (int x = begin; x < end; x++)
+            sample(s, rowX + stepX * x, rowY + stepY * x, out + (x - first) * channels);
+    }
+
+    // columns [first, first + cols) of one output row, from the source
+    // position of its column 0 and the step per column; a template argument
+    // so it inlines into the row loop
+    using RowFn = void (*)(const Sampler&, double, double, double, double, uint8_t*, int, int);
+
+    // dst holds output rows [y0, y0 + dst.rows), columns [x0, x0 + dst.cols)
+    template <RowFn warpRow>
+    void warpRows(const Sampler& s, const AffineMatrix& inv, ImageView dst, int y0, int x0)
+    {
+        parallelFor(0, dst.rows, [&](int yBegin, int yEnd)
+        {
+            for (int y = yBegin; y < yEnd; y++)
+            {
+                // source position of (0, y); each step in x adds (m[0], m[3])
+                const double rowX = inv.m[1] * (y0 + y) + inv.m[2];
+                const double rowY = inv.m[4] * (y0 + y) + inv.m[5];
+                warpRow(s, rowX, rowY, inv.m[0], inv.m[3], dst.row(y), x0, dst.cols);
+            }
+        }, 8);
+    }
+}
+
+Image imgproc::warpAffine(const Image& img, const AffineMatrix& m,
+    const WarpOptions& options)
+{
+    if (img.empty() || !m.invertible())
+        return Image{};
+
+    const int rows = options.rows > 0 ? options.rows : img.rows;
+    const int cols = options.cols > 0 ? options.cols : img.cols;
+
+    // every output pixel is written, border included
+    Image warped(rows, cols, img.channels, ImageInit::Uninitialized);
+    detail::warpAffineRows(img.view(), 0, img.rows, warped.view(), 0, 0, m, options);
+
+    return warped;
+}
+
+void imgproc::detail::warpAffineRows(ConstImageView src, int top, int srcRows,
+    ImageView dst, int y0, int x0, const AffineMatrix& m, const WarpOptions& options)
+{
+    const std::vector<uint8_t> borderPixel(dst.channels, options.borderValue);
+    const Sampler sampler{ src, top, srcRows, options.border, borderPixel.data() };
+    const AffineMatrix inv = m.inverse();
+
+    withChannels(dst.channels, [&](auto count)
+    {
+        constexpr int C = decltype(count)::value;
+        switch (options.interpolation)
+        {
+        case Interpolation::NearestNeighbour:
+            warpRows<sampleRow<C, sampleNearest<C>, 1>>(sampler, inv, dst, y0, x0);
+            break;
+        case Interpolation::Bilinear:
+            warpRows<bilinearRow<C>>(sampler, inv, dst, y0, x0);
+            break;
+        case Interpolation::Bicubic:
+            warpRows<sampleRow<C, sampleBicubic<C>, 2>>(sampler, inv, dst, y0, x0);
+            break;
+        }
+    });
+}
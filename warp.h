@@ -0,0 +1,71 @@
+#pragma once
+
+#include "imgOps.h"
+
+#include <array>
+
+namespace imgproc
+{
+    // 2x3 affine map from source pixel coordinates (x, y) to destination
+    // coordinates (x', y'), top-left origin, y down:
+    //   x' = m[0] * x + m[1] * y + m[2]
+    //   y' = m[3] * x + m[4] * y + m[5]
+    struct AffineMatrix
+    {
+        std::array<double, 6> m{ 1, 0, 0, 0, 1, 0 };
+
+        static AffineMatrix identity() { return {}; }
+        static AffineMatrix translation(double tx, double ty);
+        static AffineMatrix scaling(double sx, double sy);
+        // CCW on screen by angle degrees about (cx, cy), same sense as Rotation::rotate
+        static AffineMatrix rotation(double angle, double cx = 0, double cy = 0);
+
+        // (a * b) applies b first, then a
+        AffineMatrix operator*(const AffineMatrix& other) const;
+        // identity if the matrix is singular; check invertible() first
+        AffineMatrix inverse() const;
+        bool invertible() const { return m[0] * m[4] - m[1] * m[3] != 0; }
+
+        Point<double> apply(double x, double y) const;
+    };
+
+    enum class Interpolation { NearestNeighbour, Bilinear, Bicubic };
+
+    // what samples outside the source read as
+    // Constant: borderValue; Replicate: edge pixel; Reflect: mirrored (edge not repeated)
+    enum class BorderMode { Constant, Replicate, Reflect };
+
+    struct WarpOptions
+    {
+        Interpolation interpolation = Interpolation::Bilinear;
+        BorderMode border = BorderMode::Constant;
+        uint8_t borderValue = 0;
+        // output size; 0 keeps the source size
+        int rows = 0;
+        int cols = 0;
+    };
+
+    // One inverse-mapped pass: every output pixel is sampled from the source
+    // at M^-1 (x', y'), so any chain of scale/rotate/translate costs a single
+    // output-sized write once its matrices are composed. Bilinear weights
+    // are 8-bit, as in Rotation::rotate.
+    // A singular m (no inverse to sample through) gives an empty image.
+    Image warpAffine(const Image& img, const AffineMatrix& m,
+        const WarpOptions& options = {});
+
+    namespace detail
+    {
+        // rows [y0, y0 + dst.rows) and columns [x0, x0 + dst.cols) of
+        // warpAffine's output (options.rows/cols are ignored), for a source
+        // srcRows tall of which src holds rows [top, top + src.rows). Taps
+        // outside those rows read as the border value. For tiled evaluation
+        // (lazy.h, tiled.h); the pixels are the ones warpAffine would write.
+        void warpAffineRows(ConstImageView src, int top, int srcRows,
+            ImageView dst, int y0, int x0, const AffineMatrix& m, const WarpOptions& options);
+    }
+
+    // shift m so the whole transformed source lands inside a canvas starting
+    // at (0, 0); writes the canvas size needed
+    AffineMatrix fitCanvas(const AffineMatrix& m, int srcRows, int srcCols,
+        int& outRows, int& outCols);
+}